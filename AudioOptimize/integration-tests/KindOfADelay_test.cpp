@@ -0,0 +1,42 @@
+#include "KindOfADelay.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace OT_test
+{
+
+// feedback and cross feedback at their maximum give a loop gain of 2, an impulse must not run away
+TEST(KindOfADelayTest, maximumFeedbackStaysBounded)
+{
+    KindOfADelay<10000> sut{48000.f};
+    sut.setFeedback(1.f);
+    sut.setCrossFeedback(1.f);
+    sut.setFilterCutoff(20000.f);
+    sut.setTimeInMillisecondsLeft(50);
+    sut.setTimeInMillisecondsRight(70);
+
+    std::array<float, 512> left{};
+    std::array<float, 512> right{};
+    std::array<float, 512> outLeft{};
+    std::array<float, 512> outRight{};
+    left[0] = 1.f;
+    right[0] = 1.f;
+    float peak{0};
+    for (size_t block = 0; block < 2000; ++block)
+    {
+        sut.processBlock(left.data(), right.data(), outLeft.data(), outRight.data(), left.size());
+        left[0] = 0.f;
+        right[0] = 0.f;
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            ASSERT_TRUE(std::isfinite(outLeft[i]) && std::isfinite(outRight[i])) << block << " " << i;
+            peak = std::max({peak, std::abs(outLeft[i]), std::abs(outRight[i])});
+        }
+    }
+    EXPECT_LT(peak, 20.f);
+}
+}
@@ -66,7 +66,7 @@ class CpuTime
     float m_sampleRate{48000.f};
 };
 
-class AudioPluginAudioProcessor : public juce::AudioProcessor
+class AudioPluginAudioProcessor : public juce::AudioProcessor, private juce::Timer
 {
   public:
     juce::StringArray beatStrings = juce::StringArray{"1/64 triplet",
@@ -190,13 +190,33 @@ class AudioPluginAudioProcessor : public juce::AudioProcessor
         m_sampleRate = static_cast<size_t>(sampleRate);
         m_cpuTime.setSampleRate(m_sampleRate);
         juce::ignoreUnused(sampleRate, samplesPerBlock);
-        pluginRunner = std::make_unique<KindOfADelay<10000>>(sampleRate);
+        stopTimer();
+        auto runner = std::make_unique<KindOfADelay<10000>>(sampleRate);
+        {
+            const juce::ScopedLock lock(m_runnerLock);
+            std::swap(pluginRunner, runner);
+        }
+        startTimer(GrowIntervalInMilliseconds);
     }
 
     void releaseResources() override
     {
-        auto ptr = pluginRunner.release();
-        delete ptr;
+        stopTimer();
+        std::unique_ptr<KindOfADelay<10000>> runner;
+        {
+            const juce::ScopedLock lock(m_runnerLock);
+            std::swap(pluginRunner, runner);
+        }
+    }
+
+    // the delay lines grow on the message thread when a longer time is set
+    void timerCallback() override
+    {
+        const juce::ScopedLock lock(m_runnerLock);
+        if (pluginRunner)
+        {
+            pluginRunner->grow();
+        }
     }
 
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override
@@ -286,6 +306,7 @@ class AudioPluginAudioProcessor : public juce::AudioProcessor
 
 
     size_t m_sampleRate{48000};
+    static constexpr int GrowIntervalInMilliseconds{50};
 
     juce::AudioProcessorEditor* createEditor() override;
 
@@ -399,6 +420,10 @@ class AudioPluginAudioProcessor : public juce::AudioProcessor
     float prev_modulationSpeed;
     juce::AudioParameterInt* percentageCPU;
     std::unique_ptr<KindOfADelay<10000>> pluginRunner;
+    // stopTimer() off the message thread doesn't wait for a running timerCallback, so the replacement of pluginRunner
+    // in prepareToPlay and releaseResources takes this lock as well (processBlock doesn't, the host never calls it
+    // during those)
+    juce::CriticalSection m_runnerLock;
     CpuTime m_cpuTime{};
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginAudioProcessor)
 };
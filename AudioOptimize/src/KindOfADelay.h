@@ -10,10 +10,12 @@
 
 using namespace std::string_literals;
 
-template <size_t maxDelayTimeInMilliseconds>
+// Storage trades the noise floor of the delay lines for their memory, see DSP::DelayStorage
+template <size_t maxDelayTimeInMilliseconds, DSP::DelayStorage Storage = DSP::DelayStorage::Float32>
 class KindOfADelay
 {
     static constexpr size_t InternalBlockSize = 16;
+    static constexpr float FeedbackLimit = 4.f; // as the stage 4 clamp of MultiModeFourPoleMixerModule
     const std::array<BusinessLogic::BeatsItem, 59> m_beatsList{{
         {"1/64 triplet"s, "1/96"s, 0.0416666679084301},   // 0
         {"1/64"s, ""s, 0.0625},                           // 1
@@ -77,24 +79,20 @@ class KindOfADelay
     }};
 
   public:
-    using Diffusor = DSP::DiffusorDelayChain<5000, 5>;
+    // both channels in simd lanes, without mixing between the stages the channels stay apart
+    using Diffusor = DSP::DiffusorNetwork<5000, 5, 2>;
+    // left and right, scaled to the sample rate
+    static constexpr std::array<std::array<size_t, 5>, 2> DiffusorSizesFor48K{
+        {{172, 229, 447, 611, 1176}, {182, 219, 437, 631, 1098}}};
+    // allocates for the delay times that are used, grow() has to be called off the audio thread
+    using Delay = DSP::GrowingDigitalDelay<maxDelayTimeInMilliseconds, DSP::DelayWrapping::Modulo, Storage>;
 
     explicit KindOfADelay(float sampleRate)
-        : m_delay{DSP::DigitalDelay<maxDelayTimeInMilliseconds>(sampleRate),
-                  DSP::DigitalDelay<maxDelayTimeInMilliseconds>(sampleRate)}
-        , m_filter{DSP::MultiModeFourPoleMixerModule(sampleRate), DSP::MultiModeFourPoleMixerModule(sampleRate)}
-        , m_diffusor{Diffusor(sampleRate), Diffusor(sampleRate)}
-    {
-        m_diffusor[0].setElementSize(0, 172);
-        m_diffusor[0].setElementSize(1, 229);
-        m_diffusor[0].setElementSize(2, 447);
-        m_diffusor[0].setElementSize(3, 611);
-        m_diffusor[0].setElementSize(4, 1176);
-        m_diffusor[1].setElementSize(0, 182);
-        m_diffusor[1].setElementSize(1, 219);
-        m_diffusor[1].setElementSize(2, 437);
-        m_diffusor[1].setElementSize(3, 631);
-        m_diffusor[1].setElementSize(4, 1098);
+        : m_delay{Delay(sampleRate), Delay(sampleRate)}
+        , m_filter{DSP::ZdfFourPoleMixerModule<2>(sampleRate), DSP::ZdfFourPoleMixerModule<2>(sampleRate)}
+        , m_diffusor(sampleRate)
+    {
+        m_diffusor.setElementSizes(DiffusorSizesFor48K);
         setModulationDepth(0.03f);
         setModulationSpeed(0.3f);
     }
@@ -153,8 +151,7 @@ class KindOfADelay
 
     void setDiffuse(float nix)
     {
-        m_diffusor[0].setMix(nix);
-        m_diffusor[1].setMix(nix);
+        m_diffusor.setMix(nix);
     }
 
     void setModulationDepth(float depth)
@@ -169,6 +166,13 @@ class KindOfADelay
         m_delay[1].setModulationSpeed(speed * 0.9f); // slightly slower
     }
 
+    // not on the audio thread, e.g. by a timer: allocates the delay lines a longer time asks for
+    void grow()
+    {
+        m_delay[0].grow();
+        m_delay[1].grow();
+    }
+
     void processBlock(const float* inLeft, const float* inRight, float* outLeft, float* outRight, size_t numSamples)
     {
         for (size_t i = 0; i < numSamples; ++i)
@@ -187,8 +191,18 @@ class KindOfADelay
         }
         m_filter[0].processBlock(m_tmpFeedback[0].data(), InternalBlockSize);
         m_filter[1].processBlock(m_tmpFeedback[1].data(), InternalBlockSize);
-        m_diffusor[0].processBlock(m_tmpFeedback[0].data(), m_tmpDiffuse[0].data(), InternalBlockSize);
-        m_diffusor[1].processBlock(m_tmpFeedback[1].data(), m_tmpDiffuse[1].data(), InternalBlockSize);
+        // the linear filter has no clamp like MultiModeFourPoleMixerModule, with feedback and cross feedback up to 1
+        // the loop gain reaches 2, so the loop is bounded here
+        for (auto& channel : m_tmpFeedback)
+        {
+            for (auto& value : channel)
+            {
+                value = std::clamp(value, -FeedbackLimit, FeedbackLimit);
+            }
+        }
+        const std::array<const float*, 2> feedback{m_tmpFeedback[0].data(), m_tmpFeedback[1].data()};
+        const std::array<float*, 2> diffuse{m_tmpDiffuse[0].data(), m_tmpDiffuse[1].data()};
+        m_diffusor.processBlock(feedback.data(), diffuse.data(), InternalBlockSize);
 
         m_delay[0].processBlock(m_tmpDiffuse[0].data(), m_tmpFeed[0].data(), InternalBlockSize);
         m_delay[1].processBlock(m_tmpDiffuse[1].data(), m_tmpFeed[1].data(), InternalBlockSize);
@@ -223,9 +237,9 @@ class KindOfADelay
     DSP::PanValues<float> m_mix{0.7, 0.7f};
     float m_feedback{0.3f};
     float m_crossFeedback{0.1f};
-    std::array<DSP::DigitalDelay<maxDelayTimeInMilliseconds>, 2> m_delay;
-    std::array<DSP::MultiModeFourPoleMixerModule, 2> m_filter;
+    std::array<Delay, 2> m_delay;
+    std::array<DSP::ZdfFourPoleMixerModule<2>, 2> m_filter; // oversampled on its own, the rest runs at the sample rate
     float m_bpm{120.0f};
     std::array<float, 2> m_beats{0.25f, 0.25f};
-    std::array<Diffusor, 2> m_diffusor;
+    Diffusor m_diffusor;
 };
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <concepts>
 #include <numbers>
+#include <stdexcept>
+#include <vector>
 
 namespace DSP
 {
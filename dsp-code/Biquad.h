@@ -1,10 +1,21 @@
 
 #pragma once
 #include "AudioProcessing.h"
-
+#include "CoefficientCache.h"
+#include "CpuDispatch.h"
+#include "Denormals.h"
+#include "FastMath.h"
+#include "LockFreeSlot.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <complex>
 #include <numbers>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include <iomanip>
 #include <iostream>
@@ -42,15 +53,192 @@ enum class BiquadFilterType
     FreeCoefficients,
 };
 
+struct BiquadValues
+{
+    float b0, b1, b2, a1, a2;
+};
+
+// key: type, math, sample rate, frequency, Q, gain
+using BiquadCoefficientCache = CoefficientCache<6, BiquadValues>;
+
+/*
+ * the magnitude in dB of a cascade of sections for many frequencies, 8 frequencies side by side in lanes
+ * the power ratios of all sections are multiplied (in double, a steep cascade leaves the float range) and only the
+ * product goes through the log. The frequencies are in Hz with a sample rate, otherwise normalized (hz / sampleRate)
+ */
+inline void biquadMagnitudeResponse(const std::span<const BiquadValues> sections,
+                                    const std::span<const float> frequencies, const std::span<float> outDb,
+                                    const float sampleRate = 1.f)
+{
+    using Lanes = SimdFloat<8>;
+    constexpr auto Width = Lanes::size();
+    const auto numFrequencies = std::min(frequencies.size(), outDb.size());
+    for (size_t start = 0; start < numFrequencies; start += Width)
+    {
+        const auto count = std::min(Width, numFrequencies - start);
+        std::array<float, Width> phiValues{};
+        for (size_t k = 0; k < count; ++k)
+        {
+            const auto s = std::sin(std::numbers::pi_v<float> * frequencies[start + k] / sampleRate);
+            phiValues[k] = 4 * s * s;
+        }
+        const auto phi = Lanes::load(phiValues.data());
+
+        std::array<double, Width> product;
+        product.fill(1.);
+        for (const auto& c : sections)
+        {
+            const auto numerator =
+                Lanes::broadcast((c.b0 + c.b1 + c.b2) * (c.b0 + c.b1 + c.b2)) +
+                (Lanes::broadcast(c.b0 * c.b2) * phi - Lanes::broadcast(c.b1 * (c.b0 + c.b2) + 4 * c.b0 * c.b2)) * phi;
+            const auto denominator =
+                Lanes::broadcast((1 + c.a1 + c.a2) * (1 + c.a1 + c.a2)) +
+                (Lanes::broadcast(c.a2) * phi - Lanes::broadcast(c.a1 * (1 + c.a2) + 4 * c.a2)) * phi;
+            std::array<float, Width> ratio;
+            (numerator / denominator).store(ratio.data());
+            for (size_t k = 0; k < Width; ++k)
+            {
+                product[k] *= static_cast<double>(ratio[k]);
+            }
+        }
+        for (size_t k = 0; k < count; ++k)
+        {
+            outDb[start + k] = static_cast<float>(10 * std::log10(product[k]));
+        }
+    }
+}
+
+// keeps the last magnitude response until the coefficients change or other frequencies are asked for
+class MagnitudeResponseCache
+{
+  public:
+    void invalidate()
+    {
+        m_valid = false;
+    }
+
+    template <typename Compute>
+    void get(const std::span<const float> frequencies, const std::span<float> outDb, Compute&& compute)
+    {
+        if (!m_valid || !std::ranges::equal(frequencies, m_frequencies))
+        {
+            m_frequencies.assign(frequencies.begin(), frequencies.end());
+            m_db.resize(frequencies.size());
+            compute(std::span<const float>(m_frequencies), std::span<float>(m_db));
+            m_valid = true;
+        }
+        std::copy_n(m_db.begin(), std::min(outDb.size(), m_db.size()), outDb.begin());
+    }
+
+  private:
+    std::vector<float> m_frequencies;
+    std::vector<float> m_db;
+    bool m_valid{false};
+};
 
 class BiquadCoefficients
 {
   public:
+    using Values = BiquadValues;
+
+    void setCoefficientMath(const CoefficientMath math)
+    {
+        m_math = math;
+    }
+
+    // optional, may be shared by several filters of the same thread
+    void setCoefficientCache(BiquadCoefficientCache* cache)
+    {
+        m_cache = cache;
+    }
+
     void coefficients(BiquadFilterType type, const float sampleRate, const float frequency, const float Q,
                       const float peakGain)
+    {
+        if (m_cache != nullptr)
+        {
+            // computed from the quantized values, so a hit returns the same as a miss
+            const auto f = quantizeForCache(frequency);
+            const auto q = quantizeForCache(Q);
+            const auto gain = quantizeForCache(peakGain);
+            const BiquadCoefficientCache::Key key{static_cast<uint32_t>(type), static_cast<uint32_t>(m_math),
+                                                  cacheKeyPart(sampleRate), cacheKeyPart(f), cacheKeyPart(q),
+                                                  cacheKeyPart(gain)};
+            if (const auto* values = m_cache->find(key))
+            {
+                setValues(*values);
+                return;
+            }
+            computeValues(type, sampleRate, f, q, gain);
+            m_cache->insert(key, getCoefficients());
+            return;
+        }
+        computeValues(type, sampleRate, frequency, Q, peakGain);
+    }
+
+    [[nodiscard]] float magnitudeInDb(const float cf) const
+    {
+        return biquadMagnitudeInDb(cf, b0, b1, b2, a1, a2);
+    }
+
+    [[nodiscard]] float magnitude(const float cf) const
+    {
+        return std::pow(10.0f, magnitudeInDb(cf));
+    }
+
+    // magnitudeInDb for many normalized frequencies at once
+    void magnitudeResponse(const std::span<const float> frequencies, const std::span<float> outDb) const
+    {
+        const auto values = getCoefficients();
+        biquadMagnitudeResponse({&values, 1}, frequencies, outDb);
+    }
+
+    [[nodiscard]] Values getCoefficients() const
+    {
+        return {b0, b1, b2, a1, a2};
+    }
+
+  protected:
+    // coefficients computed elsewhere, e.g. on the thread of a handover, with the same math and cache
+    [[nodiscard]] BiquadCoefficients withSameSettings() const
+    {
+        BiquadCoefficients result;
+        result.m_math = m_math;
+        result.m_cache = m_cache;
+        return result;
+    }
+
+    void setValues(const Values& values)
+    {
+        b0 = values.b0;
+        b1 = values.b1;
+        b2 = values.b2;
+        a1 = values.a1;
+        a2 = values.a2;
+    }
+
+    float b0{1.f}, b1{0.f}, b2{0.f}, a1{0.f}, a2{0.f};
+
+  private:
+    void computeValues(const BiquadFilterType type, const float sampleRate, const float frequency, const float Q,
+                       const float peakGain)
+    {
+        if (m_math == CoefficientMath::Fast)
+        {
+            computeValues<FastMathFunctions>(type, sampleRate, frequency, Q, peakGain);
+        }
+        else
+        {
+            computeValues<ExactMathFunctions>(type, sampleRate, frequency, Q, peakGain);
+        }
+    }
+
+    template <typename Math>
+    void computeValues(BiquadFilterType type, const float sampleRate, const float frequency, const float Q,
+                       const float peakGain)
     {
         const auto Fc = frequency / sampleRate;
-        const auto K = std::tan(static_cast<float>(M_PI) * Fc);
+        const auto K = Math::tan(static_cast<float>(M_PI) * Fc);
         const auto kSquare = K * K;
         auto norm = 1 / (1 + K / Q + kSquare);
         switch (type)
@@ -84,7 +272,7 @@ class BiquadCoefficients
             case BiquadFilterType::Peak:
             {
                 auto V1 = 1.f;
-                auto V = std::pow(10.f, std::abs(peakGain) / 20.0f);
+                auto V = Math::pow10(std::abs(peakGain) / 20.0f);
                 if (peakGain < 0)
                 {
                     std::swap(V, V1);
@@ -98,7 +286,7 @@ class BiquadCoefficients
             break;
             case BiquadFilterType::LoShelf:
             {
-                const auto v2 = std::pow(10.f, peakGain / 40.f);
+                const auto v2 = Math::pow10(peakGain / 40.f);
                 const auto v = std::sqrt(v2);
                 const auto w0 = 2 * static_cast<float>(M_PI) * frequency / sampleRate;
                 const auto cosW0 = std::cos(w0);
@@ -114,7 +302,7 @@ class BiquadCoefficients
             break;
             case BiquadFilterType::HiShelf:
             {
-                const auto v2 = std::pow(10.f, peakGain / 40.f);
+                const auto v2 = Math::pow10(peakGain / 40.f);
                 const auto v = std::sqrt(v2);
                 const auto w0 = 2 * static_cast<float>(M_PI) * frequency / sampleRate;
                 const auto cosW0 = std::cos(w0);
@@ -138,18 +326,8 @@ class BiquadCoefficients
         }
     }
 
-    [[nodiscard]] float magnitudeInDb(const float cf) const
-    {
-        return biquadMagnitudeInDb(cf, b0, b1, b2, a1, a2);
-    }
-
-    [[nodiscard]] float magnitude(const float cf) const
-    {
-        return std::pow(10.0f, magnitudeInDb(cf));
-    }
-
-  protected:
-    float b0{1.f}, b1{0.f}, b2{0.f}, a1{0.f}, a2{0.f};
+    CoefficientMath m_math{CoefficientMath::Exact};
+    BiquadCoefficientCache* m_cache{nullptr};
 };
 
 class BiquadOriginal : public BiquadCoefficients
@@ -233,6 +411,16 @@ class Biquad : public BiquadCoefficients
                                [this](const float in) { return singleStepGeneric(in); });
                 break;
         }
+        if (m_flushDenormals)
+        {
+            flushDenormals(m_z.data(), m_z.size());
+        }
+    }
+
+    // flushes z1 and z2
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
     }
 
   private:
@@ -303,6 +491,7 @@ class Biquad : public BiquadCoefficients
 
   private:
     std::array<float, 2> m_z{};
+    bool m_flushDenormals{false};
 };
 
 template <BiquadFilterType type>
@@ -364,6 +553,23 @@ class BiquadStereo : public BiquadCoefficients
                 }
                 break;
         }
+        if (m_flushDenormals)
+        {
+            flushDenormals(m_z[0].data(), m_z[0].size());
+            flushDenormals(m_z[1].data(), m_z[1].size());
+        }
+    }
+
+    // flushes z1 and z2 of both channels
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
+    }
+
+    // z1 and z2 of left and right, for kernels running several filters in one pass
+    [[nodiscard]] std::array<std::array<float, 2>, 2>& state()
+    {
+        return m_z;
     }
 
   private:
@@ -452,6 +658,307 @@ class BiquadStereo : public BiquadCoefficients
         }
     }
     std::array<std::array<float, 2>, 2> m_z{{{0, 0}, {0, 0}}};
+    bool m_flushDenormals{false};
+};
+
+// stereo biquad for automation: new coefficients may come from another thread and are ramped in per sample
+// stable coefficients per sample are not enough, a tdf-ii swept quickly through resonant ones blows up
+// so it runs as state space with a state matrix [[s, p], [q, s]] of spectral norm below 1 for any stable a1, a2
+// the norm is convex, every matrix on the linear ramp contracts the state as well, whatever the ramp speed
+// the coefficients are private, computeCoefficients is the only way to change them
+template <BiquadFilterType type>
+class BiquadStereoSmooth : private BiquadCoefficients
+{
+  public:
+    using BiquadCoefficients::getCoefficients;
+    using BiquadCoefficients::magnitude;
+    using BiquadCoefficients::magnitudeInDb;
+    using BiquadCoefficients::magnitudeResponse;
+    using BiquadCoefficients::setCoefficientCache;
+    using BiquadCoefficients::setCoefficientMath;
+    using BiquadCoefficients::Values;
+
+    // may be called from another thread than processBlock, a cache belongs to the thread calling this
+    void computeCoefficients(const float sampleRate, const float frequency, const float Q, const float peakGain)
+    {
+        auto target = withSameSettings();
+        target.coefficients(type, sampleRate, frequency, Q, peakGain);
+        m_slot.push(target.getCoefficients());
+    }
+
+    // 0 applies new coefficients with the next block
+    void setSmoothingSteps(const size_t steps)
+    {
+        m_stepsSetting = steps;
+    }
+
+    void processBlock(const float* left, const float* right, float* outLeft, float* outRight, size_t numSamples)
+    {
+        Values target{};
+        if (m_slot.pull(target))
+        {
+            startRamp(target);
+        }
+
+        size_t index = 0;
+        // split into if-less blocks
+        if (m_steps)
+        {
+            const auto toIndex = std::min(m_steps, numSamples);
+            m_steps -= toIndex;
+            for (; index < toIndex; ++index)
+            {
+                m_state.b0 += m_advance.b0;
+                m_state.c1 += m_advance.c1;
+                m_state.c2 += m_advance.c2;
+                m_state.s += m_advance.s;
+                m_state.p += m_advance.p;
+                m_state.q += m_advance.q;
+                step(left[index], right[index], outLeft[index], outRight[index]);
+            }
+            if (!m_steps)
+            {
+                // getCoefficients() reports the previous target until the ramp is done
+                setValues(m_target);
+                m_state = toStateSpace(m_target);
+            }
+        }
+        for (; index < numSamples; ++index)
+        {
+            step(left[index], right[index], outLeft[index], outRight[index]);
+        }
+        if (m_flushDenormals)
+        {
+            flushDenormals(m_x[0].data(), m_x[0].size());
+            flushDenormals(m_x[1].data(), m_x[1].size());
+        }
+    }
+
+    // flushes the state space x of both channels
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
+    }
+
+  private:
+    struct StateSpace
+    {
+        float b0, c1, c2, s, p, q;
+    };
+
+    // s p q give the denominator, (z - s)^2 - p q = z^2 + a1 z + a2, c matches the numerator
+    static StateSpace toStateSpace(const Values& v)
+    {
+        const auto s = -0.5f * v.a1;
+        const auto d = s * s - v.a2; // < 0 for complex poles
+        // p = q = sqrt(d) for real poles, p = -q = sqrt(-d) rotates and scales by the pole radius
+        // near the double pole p is kept above (1 - |s|) / 2, so the norm stays below (1 + |s|) / 2
+        const auto p = std::max(std::sqrt(std::abs(d)), 0.5f * (1.f - std::abs(s)));
+        const auto e1 = v.b1 - v.b0 * v.a1;
+        const auto e2 = v.b2 - v.b0 * v.a2;
+        return {v.b0, (e2 + e1 * s) / p, e1, s, p, d / p};
+    }
+
+    void startRamp(const Values& target)
+    {
+        m_target = target;
+        m_steps = m_stepsSetting;
+        if (!m_steps)
+        {
+            setValues(target);
+            m_state = toStateSpace(target);
+            return;
+        }
+        const auto scale = 1.f / static_cast<float>(m_steps);
+        const auto end = toStateSpace(target);
+        m_advance = {(end.b0 - m_state.b0) * scale, (end.c1 - m_state.c1) * scale, (end.c2 - m_state.c2) * scale,
+                     (end.s - m_state.s) * scale,   (end.p - m_state.p) * scale,   (end.q - m_state.q) * scale};
+    }
+
+    void step(const float inLeft, const float inRight, float& outLeft, float& outRight)
+    {
+        const auto& [direct, c1, c2, s, p, q] = m_state;
+        outLeft = inLeft * direct + c1 * m_x[0][0] + c2 * m_x[0][1];
+        const auto x0 = s * m_x[0][0] + p * m_x[0][1];
+        m_x[0][1] = q * m_x[0][0] + s * m_x[0][1] + inLeft;
+        m_x[0][0] = x0;
+        outRight = inRight * direct + c1 * m_x[1][0] + c2 * m_x[1][1];
+        const auto x1 = s * m_x[1][0] + p * m_x[1][1];
+        m_x[1][1] = q * m_x[1][0] + s * m_x[1][1] + inRight;
+        m_x[1][0] = x1;
+    }
+
+    LockFreeSlot<Values> m_slot;
+    Values m_target{};
+    StateSpace m_state{toStateSpace(getCoefficients())};
+    StateSpace m_advance{};
+    size_t m_steps{0};
+    size_t m_stepsSetting{256u};
+    std::array<std::array<float, 2>, 2> m_x{{{0, 0}, {0, 0}}};
+    bool m_flushDenormals{false};
+};
+
+// N independent channels (e.g. a 32 channel bus), every channel with its own coefficients
+// state and coefficients are kept as structure of arrays, one step filters a full register of channels
+template <BiquadFilterType type, size_t NumChannels>
+class BiquadBank
+{
+  public:
+    static constexpr size_t LaneWidth = NumChannels > 4 ? 8 : 4;
+    static constexpr size_t NumGroups = (NumChannels + LaneWidth - 1) / LaneWidth;
+    static constexpr size_t PaddedChannels = NumGroups * LaneWidth;
+    using Lanes = SimdFloat<LaneWidth>;
+
+    BiquadBank()
+    {
+        m_b0.fill(1.f); // unused padding lanes just pass through
+    }
+
+    void computeCoefficients(const float sampleRate, const float frequency, const float Q, const float peakGain)
+    {
+        BiquadCoefficients designer;
+        designer.coefficients(type, sampleRate, frequency, Q, peakGain);
+        for (size_t c = 0; c < NumChannels; ++c)
+        {
+            setCoefficients(c, designer.getCoefficients());
+        }
+    }
+
+    void computeCoefficients(const size_t channel, const float sampleRate, const float frequency, const float Q,
+                             const float peakGain)
+    {
+        BiquadCoefficients designer;
+        designer.coefficients(type, sampleRate, frequency, Q, peakGain);
+        setCoefficients(channel, designer.getCoefficients());
+    }
+
+    void setCoefficients(const size_t channel, const BiquadCoefficients::Values& values)
+    {
+        m_b0[channel] = values.b0;
+        m_b1[channel] = values.b1;
+        m_b2[channel] = values.b2;
+        m_a1[channel] = values.a1;
+        m_a2[channel] = values.a2;
+    }
+
+    [[nodiscard]] float magnitudeInDb(const size_t channel, const float cf) const
+    {
+        return biquadMagnitudeInDb(cf, m_b0[channel], m_b1[channel], m_b2[channel], m_a1[channel], m_a2[channel]);
+    }
+
+    void reset()
+    {
+        m_z0.fill(0.f);
+        m_z1.fill(0.f);
+    }
+
+    // one buffer per channel, in and out may be the same buffers
+    void processBlock(const float* const* in, float* const* out, const size_t numSamples)
+    {
+        dispatch(
+            [&]
+            {
+                for (size_t first = 0; first < NumChannels; first += LaneWidth)
+                {
+                    const auto lanes = std::min(LaneWidth, NumChannels - first);
+                    alignas(32) std::array<float, LaneWidth> frame{};
+                    processGroup(
+                        first, numSamples,
+                        [&](const size_t i)
+                        {
+                            for (size_t c = 0; c < lanes; ++c)
+                            {
+                                frame[c] = in[first + c][i];
+                            }
+                            return Lanes::load(frame.data());
+                        },
+                        [&](const size_t i, const Lanes& value)
+                        {
+                            value.store(frame.data());
+                            for (size_t c = 0; c < lanes; ++c)
+                            {
+                                out[first + c][i] = frame[c];
+                            }
+                        });
+                }
+            });
+    }
+
+    // frames of NumChannels interleaved samples, the cheapest layout: no gathering, just loads and stores
+    void processBlockInterleaved(const float* in, float* out, const size_t numFrames)
+    {
+        dispatch(
+            [&]
+            {
+                for (size_t first = 0; first < NumChannels; first += LaneWidth)
+                {
+                    const auto lanes = std::min(LaneWidth, NumChannels - first);
+                    if (lanes == LaneWidth)
+                    {
+                        processGroup(
+                            first, numFrames, [&](const size_t i) { return Lanes::load(in + i * NumChannels + first); },
+                            [&](const size_t i, const Lanes& value) { value.store(out + i * NumChannels + first); });
+                    }
+                    else
+                    {
+                        alignas(32) std::array<float, LaneWidth> frame{};
+                        processGroup(
+                            first, numFrames,
+                            [&](const size_t i)
+                            {
+                                std::copy_n(in + i * NumChannels + first, lanes, frame.data());
+                                return Lanes::load(frame.data());
+                            },
+                            [&](const size_t i, const Lanes& value)
+                            {
+                                value.store(frame.data());
+                                std::copy_n(frame.data(), lanes, out + i * NumChannels + first);
+                            });
+                    }
+                }
+            });
+    }
+
+    // drop in for BiquadStereo
+    void processBlock(const float* left, const float* right, float* outLeft, float* outRight, size_t numSamples)
+        requires(NumChannels == 2)
+    {
+        const std::array<const float*, 2> in{left, right};
+        const std::array<float*, 2> out{outLeft, outRight};
+        processBlock(in.data(), out.data(), numSamples);
+    }
+
+  private:
+    // the specialised steps of Biquad only save multiplications, in lanes the generic step is as fast
+    template <typename ReadFrame, typename WriteFrame>
+    void processGroup(const size_t first, const size_t numSamples, ReadFrame read, WriteFrame write)
+    {
+        const auto b0 = Lanes::load(&m_b0[first]);
+        const auto b1 = Lanes::load(&m_b1[first]);
+        const auto b2 = Lanes::load(&m_b2[first]);
+        const auto a1 = Lanes::load(&m_a1[first]);
+        const auto a2 = Lanes::load(&m_a2[first]);
+        auto z0 = Lanes::load(&m_z0[first]);
+        auto z1 = Lanes::load(&m_z1[first]);
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto in = read(i);
+            const auto out = in * b0 + z0;
+            z0 = in * b1 + z1 - a1 * out;
+            z1 = in * b2 - a2 * out;
+            write(i, out);
+        }
+        z0.store(&m_z0[first]);
+        z1.store(&m_z1[first]);
+    }
+
+    alignas(32) std::array<float, PaddedChannels> m_b0{};
+    alignas(32) std::array<float, PaddedChannels> m_b1{};
+    alignas(32) std::array<float, PaddedChannels> m_b2{};
+    alignas(32) std::array<float, PaddedChannels> m_a1{};
+    alignas(32) std::array<float, PaddedChannels> m_a2{};
+    alignas(32) std::array<float, PaddedChannels> m_z0{};
+    alignas(32) std::array<float, PaddedChannels> m_z1{};
 };
 
 class ChebyshevBiquad
@@ -464,13 +971,48 @@ class ChebyshevBiquad
         float a1, a2;
     };
 
+    enum class Processing
+    {
+        Serial,      // sample by sample recurrence per section
+        StateSpace4, // every section computes 4 outputs per step from its state and the inputs
+        StateSpace8, // as above, 8 outputs per step
+        Pipelined,   // all sections side by side in lanes, section k works on the sample section k - 1 had before
+    };
+
+    void setProcessing(const Processing processing)
+    {
+        m_processing = processing;
+        assignToBiquads();
+    }
+
+    // the pipelined processing delays the output by one sample per section after the first
+    [[nodiscard]] size_t latencyInSamples() const
+    {
+        return m_processing == Processing::Pipelined && m_elements > 0 ? m_elements - 1 : 0;
+    }
+
     void setSampleRate(const float sampleRate)
     {
         m_sampleRate = sampleRate;
+        m_response.invalidate();
+    }
+
+    // key: type 1, order, low pass, sample rate, cutoff, ripple
+    struct CachedCoefficients
+    {
+        std::array<Coefficients, MAX_ORDER / 2 + 1> sections;
+    };
+    using Cache = CoefficientCache<6, CachedCoefficients>;
+
+    // optional, may be shared by several filters of the same thread
+    void setCoefficientCache(Cache* cache)
+    {
+        m_cache = cache;
     }
 
     void assignToBiquads()
     {
+        m_response.invalidate();
         for (size_t i = 0; i < m_elements; ++i)
         {
             for (size_t c = 0; c < 2; c++)
@@ -478,6 +1020,25 @@ class ChebyshevBiquad
                 m_biquads[c][i].setCoefficients(coefficients[i].b0, coefficients[i].b1, coefficients[i].b2,
                                                 coefficients[i].a1, coefficients[i].a2);
             }
+            // only the block form in use, it is the expensive part of a coefficient update
+            if (m_processing == Processing::StateSpace4)
+            {
+                m_stateSpace4[i] = computeStateSpace<4>(effectiveCoefficients(i));
+            }
+            else if (m_processing == Processing::StateSpace8)
+            {
+                m_stateSpace8[i] = computeStateSpace<8>(effectiveCoefficients(i));
+            }
+        }
+        for (size_t i = 0; i < PipelineLanes; ++i)
+        {
+            // unused lanes pass their input through
+            const auto c = i < m_elements ? effectiveCoefficients(i) : Coefficients{1, 0, 0, 0, 0};
+            m_pipeline.b0[i] = c.b0;
+            m_pipeline.b1[i] = c.b1;
+            m_pipeline.b2[i] = c.b2;
+            m_pipeline.a1[i] = c.a1;
+            m_pipeline.a2[i] = c.a2;
         }
     }
     struct InitialFactors
@@ -507,6 +1068,11 @@ class ChebyshevBiquad
     }
     void computeType1(const size_t order, const float fc, const float ripple, const bool isLowPass)
     {
+        if (m_cache != nullptr)
+        {
+            computeCached(true, order, fc, ripple, isLowPass);
+            return;
+        }
         m_isLowPass = isLowPass;
         m_isType1 = true;
 
@@ -585,6 +1151,11 @@ class ChebyshevBiquad
 
     void computeType2(const size_t order, const float fc, const float ripple, const bool isLowPass)
     {
+        if (m_cache != nullptr)
+        {
+            computeCached(false, order, fc, ripple, isLowPass);
+            return;
+        }
         m_isLowPass = isLowPass;
         m_isType1 = false;
         const auto [fC, beta, a] = computeFactors(order, fc, ripple);
@@ -767,6 +1338,19 @@ class ChebyshevBiquad
     }
     void processBlock(const float* in, float* out, const size_t numSamples)
     {
+        if (m_processing == Processing::Pipelined)
+        {
+            processPipelined(in, out, numSamples, m_pipelineState[0]);
+            return;
+        }
+        if (m_processing != Processing::Serial)
+        {
+            for (size_t i = 0; i < m_elements; ++i)
+            {
+                processElementStateSpace(i, i == 0 ? in : out, out, numSamples, z[i][0], z[i][1]);
+            }
+            return;
+        }
         if (m_isOdd)
         {
             if (m_elements == 1)
@@ -797,6 +1381,20 @@ class ChebyshevBiquad
     void processBlockStereo(const float* left, const float* right, float* leftOut, float* rightOut,
                             const size_t numSamples)
     {
+        if (m_processing == Processing::Pipelined)
+        {
+            processPipelinedStereo(left, right, leftOut, rightOut, numSamples);
+            return;
+        }
+        if (m_processing != Processing::Serial)
+        {
+            for (size_t i = 0; i < m_elements; ++i)
+            {
+                processElementStateSpace(i, i == 0 ? left : leftOut, leftOut, numSamples, z[i][0], z[i][1]);
+                processElementStateSpace(i, i == 0 ? right : rightOut, rightOut, numSamples, z[i][2], z[i][3]);
+            }
+            return;
+        }
         if (m_isOdd)
         {
             if (m_elements == 1 && m_isOdd)
@@ -841,6 +1439,21 @@ class ChebyshevBiquad
         return sum;
     }
 
+    // getMagnitudeInDb for many frequencies (Hz) at once, cached until the coefficients change
+    void magnitudeResponse(const std::span<const float> frequencies, const std::span<float> outDb)
+    {
+        m_response.get(frequencies, outDb,
+                       [this](const std::span<const float> hz, const std::span<float> db)
+                       {
+                           std::array<BiquadValues, MAX_ORDER / 2 + 1> sections{};
+                           for (size_t i = 0; i < m_elements; ++i)
+                           {
+                               sections[i] = m_biquads[0][i].getCoefficients();
+                           }
+                           biquadMagnitudeResponse({sections.data(), m_elements}, hz, db, m_sampleRate);
+                       });
+    }
+
     void printCoefficients()
     {
         std::cout << "// fc=" << m_fc << " ripple=" << m_ripple << " " << (m_isLowPass ? "low pass" : "high pass")
@@ -855,6 +1468,246 @@ class ChebyshevBiquad
     }
 
   private:
+    void computeCached(const bool isType1, const size_t order, const float fc, const float ripple,
+                       const bool isLowPass)
+    {
+        // computed from the quantized values, so a hit returns the same as a miss
+        const auto quantizedFc = quantizeForCache(fc);
+        const auto quantizedRipple = quantizeForCache(ripple);
+        const Cache::Key key{isType1,
+                             static_cast<uint32_t>(order),
+                             isLowPass,
+                             cacheKeyPart(m_sampleRate),
+                             cacheKeyPart(quantizedFc),
+                             cacheKeyPart(quantizedRipple)};
+        if (const auto* cached = m_cache->find(key))
+        {
+            m_isType1 = isType1;
+            m_isLowPass = isLowPass;
+            m_isOdd = (order & 1) != 0;
+            m_order = order;
+            m_elements = (order + 1) / 2;
+            m_fc = quantizedFc;
+            m_ripple = quantizedRipple;
+            std::copy_n(cached->sections.begin(), m_elements, coefficients.begin());
+            assignToBiquads();
+            return;
+        }
+
+        auto* cache = std::exchange(m_cache, nullptr);
+        isType1 ? computeType1(order, quantizedFc, quantizedRipple, isLowPass)
+                : computeType2(order, quantizedFc, quantizedRipple, isLowPass);
+        m_cache = cache;
+        CachedCoefficients values{};
+        std::copy_n(coefficients.begin(), m_elements, values.sections.begin());
+        m_cache->insert(key, values);
+    }
+
+    /*
+     * block form of a section: with the state (z0, z1) before the block and the inputs in[0..Width-1]
+     * y[k] = fromZ0[k] * z0 + fromZ1[k] * z1 + sum(fromInput[j][k] * in[j])
+     * so the outputs of a block are computed side by side in lanes instead of one after the other
+     */
+    template <size_t Width>
+    struct StateSpaceSection
+    {
+        std::array<float, Width> fromZ0;
+        std::array<float, Width> fromZ1;
+        std::array<std::array<float, Width>, Width> fromInput;
+    };
+
+    // the coefficients as they are used by the serial steps (type 2 uses b0 for b2, the odd section is 1st order)
+    [[nodiscard]] Coefficients effectiveCoefficients(const size_t index) const
+    {
+        auto c = coefficients[index];
+        if (m_isOdd && index == m_elements - 1)
+        {
+            c.b2 = 0;
+            c.a2 = 0;
+        }
+        else if (!m_isType1)
+        {
+            c.b2 = c.b0;
+        }
+        return c;
+    }
+
+    template <size_t Width>
+    static StateSpaceSection<Width> computeStateSpace(const Coefficients& c)
+    {
+        // the responses of the recurrence to each state value and to an impulse, computed in double
+        const auto respond = [&c](double z0, double z1, double impulse)
+        {
+            std::array<double, Width> y{};
+            for (size_t k = 0; k < Width; ++k)
+            {
+                const auto in = k == 0 ? impulse : 0.;
+                y[k] = in * c.b0 + z0;
+                z0 = in * c.b1 + z1 - c.a1 * y[k];
+                z1 = in * c.b2 - c.a2 * y[k];
+            }
+            return y;
+        };
+        const auto fromZ0 = respond(1, 0, 0);
+        const auto fromZ1 = respond(0, 1, 0);
+        const auto impulse = respond(0, 0, 1);
+
+        StateSpaceSection<Width> section{};
+        for (size_t k = 0; k < Width; ++k)
+        {
+            section.fromZ0[k] = static_cast<float>(fromZ0[k]);
+            section.fromZ1[k] = static_cast<float>(fromZ1[k]);
+            for (size_t j = 0; j <= k; ++j)
+            {
+                section.fromInput[j][k] = static_cast<float>(impulse[k - j]);
+            }
+        }
+        return section;
+    }
+
+    void processElementStateSpace(const size_t index, const float* in, float* out, const size_t numSamples,
+                                  float& z0, float& z1)
+    {
+        if (m_processing == Processing::StateSpace8)
+        {
+            processElementStateSpace(m_stateSpace8[index], effectiveCoefficients(index), in, out, numSamples, z0, z1);
+        }
+        else
+        {
+            processElementStateSpace(m_stateSpace4[index], effectiveCoefficients(index), in, out, numSamples, z0, z1);
+        }
+    }
+
+    template <size_t Width>
+    static void processElementStateSpace(const StateSpaceSection<Width>& section, const Coefficients& c,
+                                         const float* in, float* out, const size_t numSamples, float& z0, float& z1)
+    {
+        using Lanes = SimdFloat<Width>;
+        const auto fromZ0 = Lanes::load(section.fromZ0.data());
+        const auto fromZ1 = Lanes::load(section.fromZ1.data());
+        std::array<Lanes, Width> fromInput;
+        for (size_t j = 0; j < Width; ++j)
+        {
+            fromInput[j] = Lanes::load(section.fromInput[j].data());
+        }
+
+        const size_t blockEnd = numSamples - numSamples % Width;
+        size_t i = 0;
+        for (; i < blockEnd; i += Width)
+        {
+            auto y = fromZ0 * Lanes::broadcast(z0) + fromZ1 * Lanes::broadcast(z1);
+            for (size_t j = 0; j < Width; ++j)
+            {
+                y += fromInput[j] * Lanes::broadcast(in[i + j]);
+            }
+            // the state after the block follows from the last two inputs and outputs
+            const auto last = y[Width - 1];
+            const auto beforeLast = y[Width - 2];
+            z0 = in[i + Width - 1] * c.b1 + in[i + Width - 2] * c.b2 - c.a1 * last - c.a2 * beforeLast;
+            z1 = in[i + Width - 1] * c.b2 - c.a2 * last;
+            y.store(out + i);
+        }
+        for (; i < numSamples; ++i)
+        {
+            const auto x = in[i];
+            out[i] = x * c.b0 + z0;
+            z0 = x * c.b1 + z1 - c.a1 * out[i];
+            z1 = x * c.b2 - c.a2 * out[i];
+        }
+    }
+
+    static constexpr size_t PipelineLanes = 8;
+    static_assert(MAX_ORDER / 2 + 1 <= PipelineLanes, "every section needs a lane");
+    using PipelineFloat = SimdFloat<PipelineLanes>;
+
+    struct PipelineCoefficients
+    {
+        alignas(32) std::array<float, PipelineLanes> b0{1, 1, 1, 1, 1, 1, 1, 1};
+        alignas(32) std::array<float, PipelineLanes> b1{};
+        alignas(32) std::array<float, PipelineLanes> b2{};
+        alignas(32) std::array<float, PipelineLanes> a1{};
+        alignas(32) std::array<float, PipelineLanes> a2{};
+    };
+
+    struct PipelineState
+    {
+        alignas(32) std::array<float, PipelineLanes> z0{};
+        alignas(32) std::array<float, PipelineLanes> z1{};
+        alignas(32) std::array<float, PipelineLanes> previous{}; // the last output of every section
+    };
+
+    struct PipelineRegisters
+    {
+        explicit PipelineRegisters(const PipelineState& state)
+            : z0(PipelineFloat::load(state.z0.data()))
+            , z1(PipelineFloat::load(state.z1.data()))
+            , previous(PipelineFloat::load(state.previous.data()))
+        {
+        }
+
+        void store(PipelineState& state) const
+        {
+            z0.store(state.z0.data());
+            z1.store(state.z1.data());
+            previous.store(state.previous.data());
+        }
+
+        PipelineFloat z0, z1, previous;
+    };
+
+    struct PipelineCoefficientRegisters
+    {
+        explicit PipelineCoefficientRegisters(const PipelineCoefficients& c)
+            : b0(PipelineFloat::load(c.b0.data()))
+            , b1(PipelineFloat::load(c.b1.data()))
+            , b2(PipelineFloat::load(c.b2.data()))
+            , a1(PipelineFloat::load(c.a1.data()))
+            , a2(PipelineFloat::load(c.a2.data()))
+        {
+        }
+
+        // every section takes the output its predecessor computed one sample before
+        float step(const float in, PipelineRegisters& r, const size_t lastSection) const
+        {
+            const auto x = r.previous.shiftUp(in);
+            const auto y = x * b0 + r.z0;
+            r.z0 = x * b1 + r.z1 - a1 * y;
+            r.z1 = x * b2 - a2 * y;
+            r.previous = y;
+            return y[lastSection];
+        }
+
+        PipelineFloat b0, b1, b2, a1, a2;
+    };
+
+    void processPipelined(const float* in, float* out, const size_t numSamples, PipelineState& state) const
+    {
+        const PipelineCoefficientRegisters c{m_pipeline};
+        PipelineRegisters r{state};
+        const auto lastSection = std::max<size_t>(m_elements, 1) - 1;
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            out[i] = c.step(in[i], r, lastSection);
+        }
+        r.store(state);
+    }
+
+    void processPipelinedStereo(const float* left, const float* right, float* leftOut, float* rightOut,
+                                const size_t numSamples)
+    {
+        const PipelineCoefficientRegisters c{m_pipeline};
+        PipelineRegisters l{m_pipelineState[0]};
+        PipelineRegisters r{m_pipelineState[1]};
+        const auto lastSection = std::max<size_t>(m_elements, 1) - 1;
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            leftOut[i] = c.step(left[i], l, lastSection);
+            rightOut[i] = c.step(right[i], r, lastSection);
+        }
+        l.store(m_pipelineState[0]);
+        r.store(m_pipelineState[1]);
+    }
+
     static std::complex<float> BilinearTransform(const std::complex<float> fS)
     {
         const float fDenominator = std::norm(std::complex<float>{1, 0} - fS);
@@ -870,10 +1723,17 @@ class ChebyshevBiquad
     bool m_isLowPass{false};
     bool m_isOdd{false};
     bool m_isType1{false};
+    Processing m_processing{Processing::Serial};
+    Cache* m_cache{nullptr};
+    MagnitudeResponseCache m_response;
 
     std::array<Coefficients, MAX_ORDER> coefficients{};
     std::array<std::array<float, 4>, MAX_ORDER> z{}; // 2*2 for stereo processing
     std::array<std::array<Biquad<BiquadFilterType::FreeCoefficients>, MAX_ORDER / 2 + 1>, 2> m_biquads;
     std::array<Biquad<BiquadFilterType::FreeCoefficients>, 2> m_biquadSinglePole;
+    std::array<StateSpaceSection<4>, MAX_ORDER> m_stateSpace4{};
+    std::array<StateSpaceSection<8>, MAX_ORDER> m_stateSpace8{};
+    PipelineCoefficients m_pipeline{};
+    std::array<PipelineState, 2> m_pipelineState{};
 };
 }
@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <array>
 #include <numbers>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace DSP
@@ -29,6 +31,7 @@ class BiquadEqualizer
         {
             f.computeCoefficients(m_sampleRate, m_lowCutoff, m_lowQ, 0.f);
         }
+        m_response.invalidate();
     }
 
     void setParametric(const float hz, const float q, const float gain)
@@ -38,6 +41,7 @@ class BiquadEqualizer
         m_peakGain = gain;
         m_usePeak = m_peakGain != 0.0f;
         m_peak.computeCoefficients(m_sampleRate, m_peakCutoff, m_peakQ, m_peakGain);
+        m_response.invalidate();
     }
 
     void setTreble(const size_t order, const float hz, const float q)
@@ -49,6 +53,7 @@ class BiquadEqualizer
         {
             f.computeCoefficients(m_sampleRate, m_trebleCutoff, m_trebleQ, 0.0f);
         }
+        m_response.invalidate();
     }
 
     float getMagnitude(const float hz)
@@ -60,7 +65,40 @@ class BiquadEqualizer
         return static_cast<float>(sum);
     }
 
+    // getMagnitude for many frequencies (Hz) at once, cached until a setting changes
+    void magnitudeResponse(const std::span<const float> frequencies, const std::span<float> outDb)
+    {
+        m_response.get(frequencies, outDb,
+                       [this](const std::span<const float> hz, const std::span<float> db)
+                       {
+                           std::array<BiquadValues, 2 * MaxOrder + 1> sections{};
+                           size_t numSections = 0;
+                           for (size_t i = 0; i < m_lowOrder; ++i)
+                           {
+                               sections[numSections++] = m_hp[0].getCoefficients();
+                           }
+                           if (m_usePeak)
+                           {
+                               sections[numSections++] = m_peak.getCoefficients();
+                           }
+                           for (size_t i = 0; i < m_trebleOrder; ++i)
+                           {
+                               sections[numSections++] = m_lp[0].getCoefficients();
+                           }
+                           biquadMagnitudeResponse({sections.data(), numSections}, hz, db, m_sampleRate);
+                       });
+    }
+
+    // all filters in one pass over the samples, the states stay in registers
     void processBlock(const float* left, const float* right, float* outLeft, float* outRight, size_t numSamples)
+    {
+        const auto index = ((m_lowOrder - 1) * 2 + (m_usePeak ? 1 : 0)) * MaxOrder + m_trebleOrder - 1;
+        (this->*Kernels[index])(left, right, outLeft, outRight, numSamples);
+    }
+
+    // a pass over the samples per filter
+    void processBlockSerial(const float* left, const float* right, float* outLeft, float* outRight,
+                            size_t numSamples)
     {
         std::copy_n(left, numSamples, outLeft);
         std::copy_n(right, numSamples, outRight);
@@ -79,6 +117,108 @@ class BiquadEqualizer
     }
 
   private:
+    using Kernel = void (BiquadEqualizer::*)(const float*, const float*, float*, float*, size_t);
+    using State = std::array<std::array<float, 2>, 2>;
+
+    // the same operations as BiquadStereo
+    static void highPassStep(const BiquadValues& c, State& z, float& left, float& right)
+    {
+        const auto b0l = left * c.b0;
+        left = b0l + z[0][0];
+        z[0][0] = -2 * b0l + z[0][1] - c.a1 * left;
+        z[0][1] = b0l - c.a2 * left;
+        const auto b0r = right * c.b0;
+        right = b0r + z[1][0];
+        z[1][0] = -2 * b0r + z[1][1] - c.a1 * right;
+        z[1][1] = b0r - c.a2 * right;
+    }
+
+    static void peakStep(const BiquadValues& c, State& z, float& left, float& right)
+    {
+        const auto inLeft = left;
+        left = inLeft * c.b0 + z[0][0];
+        z[0][0] = c.b1 * (inLeft - left) + z[0][1];
+        z[0][1] = inLeft * c.b2 - c.a2 * left;
+        const auto inRight = right;
+        right = inRight * c.b0 + z[1][0];
+        z[1][0] = c.b1 * (inRight - right) + z[1][1];
+        z[1][1] = inRight * c.b2 - c.a2 * right;
+    }
+
+    static void lowPassStep(const BiquadValues& c, State& z, float& left, float& right)
+    {
+        const auto b0l = left * c.b0;
+        left = b0l + z[0][0];
+        z[0][0] = b0l * 2 + z[0][1] - c.a1 * left;
+        z[0][1] = b0l - c.a2 * left;
+        const auto b0r = right * c.b0;
+        right = b0r + z[1][0];
+        z[1][0] = b0r * 2 + z[1][1] - c.a1 * right;
+        z[1][1] = b0r - c.a2 * right;
+    }
+
+    template <size_t LowOrder, bool UsePeak, size_t TrebleOrder>
+    void processBlockFused(const float* left, const float* right, float* outLeft, float* outRight,
+                           size_t numSamples)
+    {
+        // the states are copied to locals, indexed by constants only they can be kept in registers
+        std::array<BiquadValues, LowOrder> hp;
+        std::array<State, LowOrder> hpState;
+        std::array<BiquadValues, TrebleOrder> lp;
+        std::array<State, TrebleOrder> lpState;
+        const auto peak = m_peak.getCoefficients();
+        auto peakState = m_peak.state();
+        forEach<LowOrder>(
+            [&](const auto s)
+            {
+                hp[s] = m_hp[s].getCoefficients();
+                hpState[s] = m_hp[s].state();
+            });
+        forEach<TrebleOrder>(
+            [&](const auto s)
+            {
+                lp[s] = m_lp[s].getCoefficients();
+                lpState[s] = m_lp[s].state();
+            });
+
+        // a serial recurrence as the steps of BiquadStereo, both compile to the same instructions
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto l = left[i];
+            auto r = right[i];
+            forEach<LowOrder>([&](const auto s) { highPassStep(hp[s], hpState[s], l, r); });
+            if constexpr (UsePeak)
+            {
+                peakStep(peak, peakState, l, r);
+            }
+            forEach<TrebleOrder>([&](const auto s) { lowPassStep(lp[s], lpState[s], l, r); });
+            outLeft[i] = l;
+            outRight[i] = r;
+        }
+
+        forEach<LowOrder>([&](const auto s) { m_hp[s].state() = hpState[s]; });
+        m_peak.state() = peakState;
+        forEach<TrebleOrder>([&](const auto s) { m_lp[s].state() = lpState[s]; });
+    }
+
+    // calls f with std::integral_constant 0 .. Count - 1, unrolled
+    template <size_t Count, typename F>
+    static void forEach(F&& f)
+    {
+        [&]<size_t... S>(std::index_sequence<S...>) { (f(std::integral_constant<size_t, S>{}), ...); }(
+            std::make_index_sequence<Count>{});
+    }
+
+    // one kernel for each combination of the orders and the peak filter, see processBlock for the index
+    template <size_t... Index>
+    static constexpr std::array<Kernel, sizeof...(Index)> makeKernels(std::index_sequence<Index...>)
+    {
+        return {&BiquadEqualizer::processBlockFused<Index / (2 * MaxOrder) + 1, (Index / MaxOrder) % 2 == 1,
+                                                    Index % MaxOrder + 1>...};
+    }
+
+    static constexpr auto Kernels = makeKernels(std::make_index_sequence<MaxOrder * 2 * MaxOrder>{});
+
     float m_sampleRate;
 
     // don't get confused, the treble pass is for the low frequencies
@@ -96,185 +236,330 @@ class BiquadEqualizer
     float m_peakGain{0};
     float m_trebleCutoff{500};
     float m_trebleQ{1.f / std::numbers::sqrt2_v<float>};
+    MagnitudeResponseCache m_response;
 };
 
 
-// a simple equalizer with Highpass, Peak and Lowpass
+// the equalizer of BiquadEqualizer, parameter changes are crossfaded
+//
+// Only the section (bass, peak or treble) whose parameters changed is faded: its old and new filters run side by
+// side while the other sections run once. Blocks of any size are processed in chunks, no allocation.
 template <size_t MaxOrder>
 class BiquadEqualizerSmooth
 {
   private:
-    struct EqValues
+    struct CutoffValues
+    {
+        size_t order;
+        float cutoff;
+        float qFactor;
+    };
+
+    struct PeakValues
+    {
+        float cutoff;
+        float qFactor;
+        float gain;
+    };
+
+    // bass or treble, a cascade of up to MaxOrder biquads
+    template <BiquadFilterType type>
+    struct CutoffSection
     {
-        struct CutoffFilter
+        using Values = CutoffValues;
+
+        void set(const float sampleRate, const Values& values)
+        {
+            // stages coming back hold the state of when they last ran, it would fade in as a transient
+            for (size_t i = order; i < values.order; ++i)
+            {
+                filters[i].state() = {};
+            }
+            order = values.order;
+            for (size_t i = 0; i < order; ++i)
+            {
+                filters[i].computeCoefficients(sampleRate, values.cutoff, values.qFactor, 0.f);
+            }
+        }
+
+        void processBlock(float* left, float* right, const size_t numSamples)
         {
-            unsigned order;
-            float cutoff;
-            float qFactor;
-        };
-        struct PeakFilter
+            for (size_t i = 0; i < order; ++i)
+            {
+                filters[i].processBlock(left, right, left, right, numSamples);
+            }
+        }
+
+        [[nodiscard]] float magnitudeInDb(const float cf) const
         {
-            float cutoff;
-            float qFactor;
-            float gain;
-        };
-
-        CutoffFilter low;
-        PeakFilter peak;
-        CutoffFilter treble;
+            return filters[0].magnitudeInDb(cf) * static_cast<float>(order);
+        }
+
+        std::array<BiquadStereo<type>, MaxOrder> filters{};
+        size_t order{0}; // pass-through until set
     };
 
-  public:
-    BiquadEqualizerSmooth(float sampleRate, size_t maxBlockSize)
-        : m_eq({BiquadEqualizer<MaxOrder>(sampleRate), BiquadEqualizer<MaxOrder>(sampleRate)})
-        , m_tmp({std::vector<float>(maxBlockSize, 0.f), std::vector<float>(maxBlockSize, 0.f),
-                 std::vector<float>(maxBlockSize, 0.f), std::vector<float>(maxBlockSize, 0.f)})
+    struct PeakSection
     {
-    }
+        using Values = PeakValues;
+
+        void set(const float sampleRate, const Values& values)
+        {
+            if (!active && values.gain != 0.f)
+            {
+                filter.state() = {};
+            }
+            active = values.gain != 0.f;
+            filter.computeCoefficients(sampleRate, values.cutoff, values.qFactor, values.gain);
+        }
+
+        void processBlock(float* left, float* right, const size_t numSamples)
+        {
+            if (active)
+            {
+                filter.processBlock(left, right, left, right, numSamples);
+            }
+        }
+
+        [[nodiscard]] float magnitudeInDb(const float cf) const
+        {
+            return active ? filter.magnitudeInDb(cf) : 0.f;
+        }
+
+        BiquadStereo<BiquadFilterType::Peak> filter{};
+        bool active{false};
+    };
 
-    void scheduleSwap()
+    // a section with a second set of filters to fade to, a change during a fade is applied after it
+    template <typename Section>
+    class FadingSection
     {
-        if (m_fading)
+      public:
+        using Values = typename Section::Values;
+
+        // pass-through until the first schedule() fades to values
+        FadingSection(const float sampleRate, const Values& values)
+            : m_sampleRate(sampleRate)
+            , m_values(values)
         {
-            m_scheduleSwap = true;
         }
-        else
+
+        Values& values()
         {
-            applyFade();
+            return m_values;
+        }
+
+        void schedule()
+        {
+            if (m_fadeStep > 0)
+            {
+                m_pending = true;
+            }
+            else
+            {
+                startFade();
+            }
+        }
+
+        [[nodiscard]] bool isFading() const
+        {
+            return m_fadeStep > 0;
+        }
+
+        // in place, the tmp buffers hold at least numSamples
+        void processBlock(float* left, float* right, float* tmpLeft, float* tmpRight, size_t numSamples)
+        {
+            // a fade ending within the block starts the pending one right away
+            while (numSamples > 0 && m_fadeStep > 0)
+            {
+                const auto numFade = std::min(numSamples, m_fadeStep);
+                fade(left, right, tmpLeft, tmpRight, numFade);
+                left += numFade;
+                right += numFade;
+                numSamples -= numFade;
+            }
+            if (numSamples > 0)
+            {
+                m_sections[m_current].processBlock(left, right, numSamples);
+            }
+        }
+
+        [[nodiscard]] float magnitudeInDb(const float cf) const
+        {
+            return m_sections[m_current].magnitudeInDb(cf);
+        }
+
+      private:
+        void fade(float* left, float* right, float* tmpLeft, float* tmpRight, const size_t numSamples)
+        {
+            std::copy_n(left, numSamples, tmpLeft);
+            std::copy_n(right, numSamples, tmpRight);
+            m_sections[m_current].processBlock(left, right, numSamples);
+            m_sections[1 - m_current].processBlock(tmpLeft, tmpRight, numSamples);
+            auto gain = m_fadeIn;
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                left[i] += gain * (tmpLeft[i] - left[i]);
+                right[i] += gain * (tmpRight[i] - right[i]);
+                gain += m_fadeAdvance;
+            }
+            m_fadeIn = gain;
+            m_fadeStep -= numSamples;
+            if (m_fadeStep == 0)
+            {
+                m_current = 1 - m_current;
+                if (m_pending)
+                {
+                    startFade();
+                }
+            }
+        }
+
+        void startFade()
+        {
+            m_pending = false;
+            // the new filters continue from the state of the current ones
+            m_sections[1 - m_current] = m_sections[m_current];
+            m_sections[1 - m_current].set(m_sampleRate, m_values);
+            m_fadeStep = FadeLength;
+            m_fadeAdvance = 1.f / static_cast<float>(FadeLength);
+            m_fadeIn = 0.f;
         }
-    }
 
-    void applyFade()
-    {
-        m_scheduleSwap = false;
-        m_newValues = m_scheduledValues;
-        m_eq[1 - m_currentEq].setBass(m_newValues.low.order, m_newValues.low.cutoff, m_newValues.low.qFactor);
-        m_eq[1 - m_currentEq].setParametric(m_newValues.peak.cutoff, m_newValues.peak.qFactor, m_newValues.peak.gain);
-        m_eq[1 - m_currentEq].setTreble(m_newValues.treble.order, m_newValues.treble.cutoff,
-                                        m_newValues.treble.qFactor);
-        m_fadeStep = 4096;
-        m_fadeAdvance = 1.f / static_cast<float>(m_fadeStep);
-        m_fadeIn = 0.0f;
-        m_fadeOut = 1.0f;
-        m_fading = true;
+        float m_sampleRate;
+        Values m_values;
+        std::array<Section, 2> m_sections{};
+        size_t m_current{0};
+        size_t m_fadeStep{0};
+        float m_fadeIn{0.f};
+        float m_fadeAdvance{0.f};
+        bool m_pending{false};
+    };
+
+  public:
+    // any block size is processed, maxBlockSize is only kept for compatibility
+    explicit BiquadEqualizerSmooth(float sampleRate, [[maybe_unused]] size_t maxBlockSize = 0)
+        : m_sampleRate(sampleRate)
+        , m_low(sampleRate, {1, 100.0f, 0.707f})
+        , m_peak(sampleRate, {1000.0f, 0.707f, 0})
+        , m_treble(sampleRate, {1, 8000.f, 0.707f})
+    {
     }
 
     void setBassOrder(size_t order)
     {
-        m_scheduledValues.low.order = std::clamp<size_t>(order, 1, MaxOrder);
-        scheduleSwap();
+        m_low.values().order = std::clamp<size_t>(order, 1, MaxOrder);
+        schedule(m_low);
     }
 
     void setBassCutoff(float hz)
     {
-        m_scheduledValues.low.cutoff = std::clamp<float>(hz, 10.f, 24000.0f);
-        scheduleSwap();
+        m_low.values().cutoff = std::clamp<float>(hz, 10.f, 24000.0f);
+        schedule(m_low);
     }
 
     void setBassQ(float q)
     {
-        m_scheduledValues.low.qFactor = std::clamp<float>(q, 0.001, 20.0);
-        scheduleSwap();
+        m_low.values().qFactor = std::clamp<float>(q, 0.001, 20.0);
+        schedule(m_low);
     }
 
     void setParametricCutoff(float hz)
     {
-        m_scheduledValues.peak.cutoff = std::clamp<float>(hz, 10.f, 24000.0f);
-        scheduleSwap();
+        m_peak.values().cutoff = std::clamp<float>(hz, 10.f, 24000.0f);
+        schedule(m_peak);
     }
 
     void setParametricQ(float q)
     {
-        m_scheduledValues.peak.qFactor = std::clamp<float>(q, 0.001, 20.0);
-        scheduleSwap();
+        m_peak.values().qFactor = std::clamp<float>(q, 0.001, 20.0);
+        schedule(m_peak);
     }
 
     void setParametricGain(float gain)
     {
-        m_scheduledValues.peak.gain = std::clamp<float>(gain, -24.f, 24.f);
-        scheduleSwap();
+        m_peak.values().gain = std::clamp<float>(gain, -24.f, 24.f);
+        schedule(m_peak);
     }
 
     void setTrebleOrder(size_t order)
     {
-        m_scheduledValues.treble.order = std::clamp<size_t>(order, 1, MaxOrder);
-        scheduleSwap();
+        m_treble.values().order = std::clamp<size_t>(order, 1, MaxOrder);
+        schedule(m_treble);
     }
 
     void setTrebleCutoff(float hz)
     {
-        m_scheduledValues.treble.cutoff = std::clamp<float>(hz, 10.f, 24000.0f);
-        scheduleSwap();
+        m_treble.values().cutoff = std::clamp<float>(hz, 10.f, 24000.0f);
+        schedule(m_treble);
     }
 
     void setTrebleQ(float q)
     {
-        m_scheduledValues.treble.qFactor = std::clamp<float>(q, 0.001, 20.0);
-        scheduleSwap();
+        m_treble.values().qFactor = std::clamp<float>(q, 0.001, 20.0);
+        schedule(m_treble);
     }
 
+    [[nodiscard]] bool isFading() const
+    {
+        return m_low.isFading() || m_peak.isFading() || m_treble.isFading();
+    }
 
+    // of the settings faded to or reached
     float getMagnitude(float hz)
     {
-        return m_eq[m_currentEq].getMagnitude(hz);
+        const auto cf = hz / m_sampleRate;
+        return m_low.magnitudeInDb(cf) + m_peak.magnitudeInDb(cf) + m_treble.magnitudeInDb(cf);
     }
 
     void processBlock(const float* left, const float* right, float* outLeft, float* outRight, const size_t numSamples)
     {
-        assert(numSamples <= m_tmp[0].size());
-        if (m_fading)
+        for (size_t offset = 0; offset < numSamples; offset += ChunkSize)
         {
-            m_eq[0].processBlock(left, right, m_tmp[0].data(), m_tmp[1].data(), numSamples);
-            m_eq[1].processBlock(left, right, m_tmp[2].data(), m_tmp[3].data(), numSamples);
-            const auto indexFadeIn = (1 - m_currentEq) * 2;
-            const auto indexFadeOut = m_currentEq * 2;
-            for (size_t i = 0; i < numSamples; ++i)
+            const auto chunk = std::min(ChunkSize, numSamples - offset);
+            auto* chunkLeft = outLeft + offset;
+            auto* chunkRight = outRight + offset;
+            if (left != outLeft)
             {
-                if (m_fadeStep)
-                {
-                    outLeft[i] = m_fadeIn * m_tmp[indexFadeIn][i] + m_fadeOut * m_tmp[indexFadeOut + 1][i];
-                    outRight[i] = m_fadeIn * m_tmp[indexFadeIn][i] + m_fadeOut * m_tmp[indexFadeOut + 1][i];
-                    --m_fadeStep;
-                    m_fadeIn += m_fadeAdvance;
-                    m_fadeOut -= m_fadeAdvance;
-                    if (m_fadeStep == 0)
-                    {
-                        m_fading = false;
-                        while (++i < numSamples)
-                        {
-                            outLeft[i] = m_tmp[indexFadeIn][i];
-                            outRight[i] = m_tmp[indexFadeIn + 1][i];
-                        }
-                        // swap eq set, we are done with fade
-                        m_currentEq = 1 - m_currentEq;
-                        if (m_scheduleSwap)
-                        {
-                            applyFade();
-                        }
-                    }
-                }
+                std::copy_n(left + offset, chunk, chunkLeft);
+            }
+            if (right != outRight)
+            {
+                std::copy_n(right + offset, chunk, chunkRight);
             }
+            m_low.processBlock(chunkLeft, chunkRight, m_tmpLeft.data(), m_tmpRight.data(), chunk);
+            m_peak.processBlock(chunkLeft, chunkRight, m_tmpLeft.data(), m_tmpRight.data(), chunk);
+            m_treble.processBlock(chunkLeft, chunkRight, m_tmpLeft.data(), m_tmpRight.data(), chunk);
         }
-        else
+    }
+
+  private:
+    // the eq is pass-through until the first setter, which fades in all sections
+    template <typename Section>
+    void schedule(Section& section)
+    {
+        if (!m_engaged)
         {
-            std::copy_n(left, numSamples, outLeft);
-            std::copy_n(right, numSamples, outRight);
-            m_eq[m_currentEq].processBlock(outLeft, outRight, outLeft, outRight, numSamples);
+            m_engaged = true;
+            m_low.schedule();
+            m_peak.schedule();
+            m_treble.schedule();
+            return;
         }
+        section.schedule();
     }
 
-  private:
-    std::array<std::vector<float>, 4> m_tmp;
-    std::array<BiquadEqualizer<MaxOrder>, 2> m_eq{};
-    int m_currentEq{0};
-    EqValues m_newValues{1, 100.0f, 0.707f, 1000.0f, 0.707f, 0, 1, 8000.f, 0.707f};
-    EqValues m_scheduledValues{1, 100.0f, 0.707f, 1000.0f, 0.707f, 0, 1, 8000.f, 0.707f};
-    bool m_fading{false};
-    float m_fadeIn{0.f};
-    float m_fadeOut{0.f};
-    float m_fadeAdvance{0.f};
-    size_t m_fadeStep{0};
-    bool m_scheduleSwap{false};
+    static constexpr size_t FadeLength{4096};
+    static constexpr size_t ChunkSize{128};
+
+    float m_sampleRate;
+    // don't get confused, the treble pass is for the low frequencies
+    FadingSection<CutoffSection<BiquadFilterType::HighPass>> m_low;
+    FadingSection<PeakSection> m_peak;
+    FadingSection<CutoffSection<BiquadFilterType::LowPass>> m_treble;
+    std::array<float, ChunkSize> m_tmpLeft{};
+    std::array<float, ChunkSize> m_tmpRight{};
+    bool m_engaged{false};
 };
 
 }
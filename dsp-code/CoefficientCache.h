@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace DSP
+{
+
+// keeps the upper 12 mantissa bits, values less than about 0.025 % apart share a cache entry
+[[nodiscard]] inline float quantizeForCache(const float value)
+{
+    constexpr uint32_t droppedBits = (1u << 11) - 1;
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(value) & ~droppedBits);
+}
+
+[[nodiscard]] inline uint32_t cacheKeyPart(const float value)
+{
+    return std::bit_cast<uint32_t>(value);
+}
+
+/*
+ * two way set associative cache for computed filter coefficients, no allocation after construction
+ *
+ * The key is made of the (quantized) parameters the coefficients are computed from. A new entry replaces the less
+ * recently used one of its set. Not thread safe, a cache belongs to the thread that computes the coefficients.
+ */
+template <size_t KeySize, typename Value, size_t NumEntries = 1024>
+class CoefficientCache
+{
+    static_assert(std::has_single_bit(NumEntries) && NumEntries >= 2, "NumEntries must be a power of 2");
+
+  public:
+    using Key = std::array<uint32_t, KeySize>;
+
+    // nullptr if the key is not cached
+    [[nodiscard]] const Value* find(const Key& key)
+    {
+        auto& set = m_sets[setIndex(key)];
+        for (size_t way = 0; way < Ways; ++way)
+        {
+            if (set.entries[way].valid && set.entries[way].key == key)
+            {
+                set.recent = way;
+                ++m_hits;
+                return &set.entries[way].value;
+            }
+        }
+        ++m_misses;
+        return nullptr;
+    }
+
+    void insert(const Key& key, const Value& value)
+    {
+        auto& set = m_sets[setIndex(key)];
+        const auto way = 1 - set.recent;
+        set.entries[way] = {key, value, true};
+        set.recent = way;
+    }
+
+    void clear()
+    {
+        for (auto& set : m_sets)
+        {
+            for (auto& entry : set.entries)
+            {
+                entry.valid = false;
+            }
+        }
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+    [[nodiscard]] size_t hits() const
+    {
+        return m_hits;
+    }
+
+    [[nodiscard]] size_t misses() const
+    {
+        return m_misses;
+    }
+
+  private:
+    static constexpr size_t Ways = 2;
+    static constexpr size_t NumSets = NumEntries / Ways;
+
+    struct Entry
+    {
+        Key key{};
+        Value value{};
+        bool valid{false};
+    };
+
+    struct Set
+    {
+        std::array<Entry, Ways> entries{};
+        size_t recent{0};
+    };
+
+    static size_t setIndex(const Key& key)
+    {
+        uint32_t hash{0};
+        for (const auto k : key)
+        {
+            hash = std::rotl(hash, 5) ^ k;
+            hash *= 0x9E3779B1u;
+        }
+        // the quantized floats have their low bits cleared, the upper ones have to end up in the index
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6Bu;
+        hash ^= hash >> 13;
+        return hash & (NumSets - 1);
+    }
+
+    std::array<Set, NumSets> m_sets{};
+    size_t m_hits{0};
+    size_t m_misses{0};
+};
+}
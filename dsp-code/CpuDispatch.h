@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+
+/*
+ * runtime selection of the instruction set for the hot loops
+ *
+ * The build targets a baseline (e.g. SSE2 or NEON). A kernel passed to dispatch() is additionally compiled for AVX2
+ * and AVX-512 (gcc and clang on x86): the lambda is inlined into a function with the target attribute, so the very
+ * same loop is vectorized for the wider registers. The variant is picked once by CPUID, forceIsa() overrides it
+ * for tests and benchmarks.
+ *
+ * Only loops over independent samples or channels gain from it. A serial recurrence (a single biquad or one pole)
+ * can't use the wider registers, the switch around the inlined loop only costs there.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DSP_CPU_DISPATCH 1
+#endif
+
+namespace DSP
+{
+
+enum class Isa
+{
+    Generic, // what the build targets
+    Avx2,    // avx2 and fma
+    Avx512,  // avx512f and avx512vl on top of avx2
+};
+
+[[nodiscard]] inline bool isSupported(const Isa isa)
+{
+#ifdef DSP_CPU_DISPATCH
+    switch (isa)
+    {
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::Avx512:
+            return isSupported(Isa::Avx2) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl");
+        default:
+            return true;
+    }
+#else
+    return isa == Isa::Generic;
+#endif
+}
+
+[[nodiscard]] inline Isa detectIsa()
+{
+    if (isSupported(Isa::Avx512))
+    {
+        return Isa::Avx512;
+    }
+    if (isSupported(Isa::Avx2))
+    {
+        return Isa::Avx2;
+    }
+    return Isa::Generic;
+}
+
+inline std::atomic<Isa>& selectedIsa()
+{
+    static std::atomic<Isa> isa{detectIsa()};
+    return isa;
+}
+
+[[nodiscard]] inline Isa activeIsa()
+{
+    return selectedIsa().load(std::memory_order_relaxed);
+}
+
+// returns false and keeps the current selection if the cpu lacks the instruction set
+inline bool forceIsa(const Isa isa)
+{
+    if (!isSupported(isa))
+    {
+        return false;
+    }
+    selectedIsa().store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+// back to the detected instruction set
+inline void resetIsa()
+{
+    selectedIsa().store(detectIsa(), std::memory_order_relaxed);
+}
+
+#ifdef DSP_CPU_DISPATCH
+template <typename Kernel>
+[[gnu::target("avx2,fma"), gnu::flatten]] inline void runAvx2(Kernel& kernel)
+{
+    kernel();
+}
+
+template <typename Kernel>
+[[gnu::target("avx512f,avx512vl,avx2,fma"), gnu::flatten]] inline void runAvx512(Kernel& kernel)
+{
+    kernel();
+}
+#endif
+
+// runs the kernel, a lambda holding the loop, compiled for the active instruction set
+template <typename Kernel>
+inline void dispatch(Kernel&& kernel)
+{
+#ifdef DSP_CPU_DISPATCH
+    switch (activeIsa())
+    {
+        case Isa::Avx512:
+            runAvx512(kernel);
+            return;
+        case Isa::Avx2:
+            runAvx2(kernel);
+            return;
+        default:
+            break;
+    }
+#endif
+    kernel();
+}
+}
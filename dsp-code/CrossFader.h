@@ -1,5 +1,7 @@
 #pragma once
 
+#include "CpuDispatch.h"
+
 #include <algorithm>
 #include <cmath>
 namespace DSP
@@ -48,10 +50,14 @@ class CrossFader
             std::copy(fadeIn, fadeIn + numSamples, target);
             return;
         }
-        for (size_t i = 0; i < numSamples; ++i)
-        {
-            target[i] = step(fadeIn[i], fadeOut[i]);
-        }
+        dispatch(
+            [&]
+            {
+                for (size_t i = 0; i < numSamples; ++i)
+                {
+                    target[i] = step(fadeIn[i], fadeOut[i]);
+                }
+            });
     }
 
     [[nodiscard]] size_t width() const
@@ -110,10 +116,14 @@ class CrossFaderLinear
             std::copy(fadeIn, fadeIn + numSamples, target);
             return;
         }
-        for (size_t i = 0; i < numSamples; ++i)
-        {
-            target[i] = step(fadeIn[i], fadeOut[i]);
-        }
+        dispatch(
+            [&]
+            {
+                for (size_t i = 0; i < numSamples; ++i)
+                {
+                    target[i] = step(fadeIn[i], fadeOut[i]);
+                }
+            });
     }
 
     [[nodiscard]] size_t width() const
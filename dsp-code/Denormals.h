@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DSP_DENORMALS_X86 1
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define DSP_DENORMALS_AARCH64 1
+#elif defined(__arm__) && defined(__ARM_FP) && (defined(__GNUC__) || defined(__clang__))
+#define DSP_DENORMALS_ARM 1
+#endif
+
+namespace DSP
+{
+
+/*
+ * subnormal floats are up to 100 times slower to compute with on many cpus, the decaying state of a recursive filter
+ * ends up there after an impulse and a long enough silence
+ *
+ * ScopedFlushDenormals sets flush to zero (and denormals are zero on x86) for the current thread while it lives,
+ * like juce::ScopedNoDenormals does within the plugin. Where the mode can't be set, the filters have an opt-in
+ * setFlushDenormals() that zeroes their state below DenormalThreshold once per block.
+ */
+class ScopedFlushDenormals
+{
+  public:
+    ScopedFlushDenormals()
+        : m_previous(readMode())
+    {
+        writeMode(m_previous | FlushBits);
+    }
+
+    ~ScopedFlushDenormals()
+    {
+        writeMode(m_previous);
+    }
+
+    ScopedFlushDenormals(const ScopedFlushDenormals&) = delete;
+    ScopedFlushDenormals& operator=(const ScopedFlushDenormals&) = delete;
+
+    // false if the floating point mode of this platform is not known, the guard does nothing then
+    [[nodiscard]] static constexpr bool isAvailable()
+    {
+        return FlushBits != 0;
+    }
+
+  private:
+#if defined(DSP_DENORMALS_X86)
+    using Mode = uint32_t;
+    static constexpr Mode FlushBits = 0x8040; // flush to zero and denormals are zero in mxcsr
+
+    static Mode readMode()
+    {
+        return _mm_getcsr();
+    }
+
+    static void writeMode(const Mode mode)
+    {
+        _mm_setcsr(mode);
+    }
+#elif defined(DSP_DENORMALS_AARCH64)
+    using Mode = uint64_t;
+    static constexpr Mode FlushBits = Mode{1} << 24; // fz in fpcr
+
+    static Mode readMode()
+    {
+        Mode mode;
+        asm volatile("mrs %0, fpcr" : "=r"(mode));
+        return mode;
+    }
+
+    static void writeMode(const Mode mode)
+    {
+        asm volatile("msr fpcr, %0" : : "r"(mode));
+    }
+#elif defined(DSP_DENORMALS_ARM)
+    using Mode = uint32_t;
+    static constexpr Mode FlushBits = Mode{1} << 24; // fz in fpscr
+
+    static Mode readMode()
+    {
+        Mode mode;
+        asm volatile("vmrs %0, fpscr" : "=r"(mode));
+        return mode;
+    }
+
+    static void writeMode(const Mode mode)
+    {
+        asm volatile("vmsr fpscr, %0" : : "r"(mode));
+    }
+#else
+    using Mode = uint32_t;
+    static constexpr Mode FlushBits = 0;
+
+    static Mode readMode()
+    {
+        return 0;
+    }
+
+    static void writeMode(const Mode)
+    {
+    }
+#endif
+
+    Mode m_previous;
+};
+
+// far above the smallest normal float (1.2e-38), a state this small is inaudible and decays into subnormals soon
+inline constexpr float DenormalThreshold{1e-15f};
+
+// setFlushDenormals() of the filters is for platforms without ScopedFlushDenormals: the state is zeroed with these
+// after each block once it is tiny, a subnormal may occur within the block still
+[[nodiscard]] inline float flushDenormal(const float value)
+{
+    return std::abs(value) < DenormalThreshold ? 0.f : value;
+}
+
+inline void flushDenormals(float* values, const size_t numValues)
+{
+    for (size_t i = 0; i < numValues; ++i)
+    {
+        values[i] = flushDenormal(values[i]);
+    }
+}
+}
@@ -1,89 +1,243 @@
 #pragma once
 
 #include "AudioProcessing.h"
+#include "OnePoleFilter.h"
+#include "Simd.h"
 #include "TwoLatticeAllPass.h"
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <vector>
 
 namespace DSP
 {
 
-template <size_t MaxDelayLength, size_t NumElements>
-class DiffusorDelayChain
+// the former check of every candidate, for numbers beyond the table
+[[nodiscard]] constexpr bool isPrimeByTrialDivision(const unsigned startValue)
 {
-    template <typename T, size_t N, size_t... Ns, typename... Args>
-    auto makeArrayImpl(const std::index_sequence<Ns...>&, Args&&... args)
+    auto n = startValue;
+    if (n == 2u || n == 3u)
     {
-        const auto create = [&args...](size_t) { return T(args...); };
-        return std::array<T, N>{create(Ns)...};
+        return true;
     }
-
-    template <typename T, size_t N, typename... Args>
-    auto makeArray(Args&&... args)
+    if (n <= 1u || n % 2u == 0 || n % 3u == 0)
     {
-        return makeArrayImpl<T, N>(std::make_index_sequence<N>(), std::forward<Args>(args)...);
+        return false;
     }
-
-
-    explicit DiffusorDelayChain(const float sampleRate)
-        : m_sampleRate(sampleRate)
-        , m_delay{makeArray<DSP::TwoLatticeAllPass<MaxDelayLength>, NumElements>(sampleRate)}
+    for (auto i = 5u; i * i <= n; i += 6u)
     {
-        for (auto& m : m_delay)
+        if (n % i == 0 || n % (i + 2u) == 0)
         {
-            m.setFeedback(m_feedback);
-            m.setLowpassCutoff(8000);
+            return false;
         }
     }
+    return true;
+}
 
-  public:
-    [[nodiscard]] auto isPrimeNumber(const unsigned startValue)
+// covers the diffusor lengths up to 192 kHz
+inline constexpr unsigned PrimeTableSize{8192};
+
+// the smallest odd prime >= n for each n < PrimeTableSize, a sieve evaluated by the compiler
+inline constexpr auto NextOddPrimeTable = []
+{
+    constexpr unsigned sieveSize{PrimeTableSize + 64}; // beyond the prime gaps of this range
+    std::array<bool, sieveSize> composite{};
+    for (unsigned i = 2; i * i < sieveSize; ++i)
     {
-        auto n = startValue;
-        if (n == 2u || n == 3u)
+        if (!composite[i])
         {
-            return true;
+            for (auto j = i * i; j < sieveSize; j += i)
+            {
+                composite[j] = true;
+            }
         }
-        if (n <= 1u || n % 2u == 0 || n % 3u == 0)
+    }
+    std::array<uint16_t, PrimeTableSize> table{};
+    auto next = sieveSize - 1;
+    while (composite[next])
+    {
+        --next;
+    }
+    for (auto n = sieveSize - 1; n >= 3; --n)
+    {
+        next = composite[n] ? next : n;
+        if (n < PrimeTableSize)
         {
-            return false;
+            table[n] = static_cast<uint16_t>(next);
         }
-        for (auto i = 5u; i * i <= n; i += 6u)
+    }
+    table[0] = table[1] = table[2] = 3;
+    return table;
+}();
+
+[[nodiscard]] constexpr bool isPrimeNumber(const unsigned startValue)
+{
+    if (startValue < PrimeTableSize)
+    {
+        return startValue == 2u || NextOddPrimeTable[startValue] == startValue;
+    }
+    return isPrimeByTrialDivision(startValue);
+}
+
+// the first prime from the larger of both on, delay lengths of diffusors without common factors
+[[nodiscard]] constexpr unsigned getUsefulPrime(const unsigned minimumValue, const unsigned wIn)
+{
+    auto n = std::max(minimumValue, wIn) | 1u;
+    if (n < PrimeTableSize)
+    {
+        return NextOddPrimeTable[n];
+    }
+    for (size_t m = 0; m < 250u; ++m)
+    {
+        if (isPrimeByTrialDivision(n))
         {
-            if (n % i == 0 || n % (i + 2u) == 0)
-            {
-                return false;
-            }
+            return n;
         }
-        return true;
+        n += 2u;
     }
+    return n;
+}
 
-    [[nodiscard]] auto getUsefulPrime(const unsigned minimumValue, const unsigned wIn) -> decltype(wIn)
+// the largest odd prime up to maximumValue (3 for anything below)
+[[nodiscard]] constexpr unsigned getPrimeAtMost(const unsigned maximumValue)
+{
+    auto n = std::max(maximumValue, 3u);
+    n -= n % 2u == 0 ? 1u : 0u;
+    while (!isPrimeNumber(n))
+    {
+        n -= 2u;
+    }
+    return n;
+}
+
+// the lengths in samples of diffusor stages given in samples at 48 kHz, e.g. all stages of all channels
+// Each is a prime from 101 on and no two are the same, so no two delays have a common factor, at any sample rate.
+// None is longer than maxLength, the delay line: the widths beyond take the largest primes below it instead.
+template <size_t NumLengths>
+[[nodiscard]] constexpr std::array<size_t, NumLengths> computeDiffusorLengths(
+    const std::array<size_t, NumLengths>& widthsFor48K, const float sampleRate,
+    const size_t maxLength = std::numeric_limits<unsigned>::max())
+{
+    const auto limit = static_cast<unsigned>(std::min<size_t>(maxLength, std::numeric_limits<unsigned>::max()));
+    std::array<size_t, NumLengths> lengths{};
+    for (size_t i = 0; i < NumLengths; ++i)
     {
-        auto n = std::max(minimumValue, wIn) | 1u;
-        for (size_t m = 0; m < 250u; ++m)
+        const auto width = static_cast<float>(widthsFor48K[i]) * sampleRate / 48000.f;
+        auto prime = getUsefulPrime(101, static_cast<unsigned>(width));
+        auto downwards = prime > limit;
+        prime = downwards ? getPrimeAtMost(limit) : prime;
+        while (std::find(lengths.begin(), lengths.begin() + i, prime) != lengths.begin() + i)
         {
-            if (isPrimeNumber(n))
+            assert(prime > 3u);
+            if (!downwards)
             {
-                return n;
+                prime = getUsefulPrime(101, prime + 2u);
+                downwards = prime > limit;
+                prime = downwards ? getPrimeAtMost(limit) : prime;
+            }
+            else
+            {
+                prime = getPrimeAtMost(prime - 2u);
             }
-            n += 2u;
         }
-        return n;
+        lengths[i] = prime;
+    }
+    return lengths;
+}
+
+// the delay lines of diffusors in one allocation, e.g. both chains of a stereo diffusor
+class DiffusorArena
+{
+  public:
+    explicit DiffusorArena(const size_t numValues)
+        : m_memory(numValues, 0.f)
+    {
+    }
+
+    // numValues of the arena that were not handed out yet
+    float* allocate(const size_t numValues)
+    {
+        assert(m_used + numValues <= m_memory.size());
+        auto* values = m_memory.data() + m_used;
+        m_used += numValues;
+        return values;
+    }
+
+  private:
+    std::vector<float> m_memory;
+    size_t m_used{0};
+};
+
+/*
+ * NumElements lattice allpasses in a row with a dry/wet mix
+ *
+ * The delay lines of all elements lie one after the other in an arena, either an own one or one shared with other
+ * chains. A block goes through all elements sub-block by sub-block, each short enough not to wrap in any delay line
+ * and not to read what it writes (not longer than the shortest element), so it stays in the cache from the first to
+ * the last element. The result is the same as of a TwoLatticeAllPass per element.
+ */
+template <size_t MaxDelayLength, size_t NumElements>
+class DiffusorDelayChain
+{
+  public:
+    static constexpr size_t ArenaSize{MaxDelayLength * NumElements};
+    static constexpr size_t MaxSubBlockSize{MaxLatticeSegmentSize};
+
+    explicit DiffusorDelayChain(const float sampleRate)
+        : m_ownArena(std::make_unique<DiffusorArena>(ArenaSize))
+        , m_memory(m_ownArena->allocate(ArenaSize))
+        , m_sampleRate(sampleRate)
+        , m_lowpass{makeLowpasses(sampleRate, std::make_index_sequence<NumElements>{})}
+    {
+        setCutoff(8000);
+        m_size.fill(MaxDelayLength);
+    }
+
+    // ArenaSize values of the arena
+    DiffusorDelayChain(const float sampleRate, DiffusorArena& arena)
+        : m_memory(arena.allocate(ArenaSize))
+        , m_sampleRate(sampleRate)
+        , m_lowpass{makeLowpasses(sampleRate, std::make_index_sequence<NumElements>{})}
+    {
+        setCutoff(8000);
+        m_size.fill(MaxDelayLength);
+    }
+
+    [[nodiscard]] auto isPrimeNumber(const unsigned startValue)
+    {
+        return DSP::isPrimeNumber(startValue);
+    }
+
+    [[nodiscard]] auto getUsefulPrime(const unsigned minimumValue, const unsigned wIn)
+    {
+        return DSP::getUsefulPrime(minimumValue, wIn);
     }
 
     void setElementSize(size_t index, size_t widthFor48K)
     {
-        auto w = getUsefulPrime(101, static_cast<unsigned>(widthFor48K * 48000.f / m_sampleRate));
-        m_delay[index].setSize(w);
+        setElementLength(index, computeDiffusorLengths<1>({widthFor48K}, m_sampleRate, MaxDelayLength)[0]);
+    }
+
+    // all elements at once, their lengths are different primes
+    void setElementSizes(const std::array<size_t, NumElements>& widthsFor48K)
+    {
+        const auto lengths = computeDiffusorLengths(widthsFor48K, m_sampleRate, MaxDelayLength);
+        for (size_t index = 0; index < NumElements; ++index)
+        {
+            setElementLength(index, lengths[index]);
+        }
     }
 
     void setCutoff(const float hz)
     {
-        for (auto& r : m_delay)
+        for (auto& lowpass : m_lowpass)
         {
-            r.setLowpassCutoff(hz);
+            lowpass.setCutoff(hz);
         }
     }
 
@@ -95,32 +249,298 @@ class DiffusorDelayChain
     void processBlock(const float* source, float* target, const size_t numSamples)
     {
         std::copy_n(source, numSamples, target);
-        if (std::fpclassify(m_feedback) == FP_ZERO || std::fpclassify(std::get<1>(m_mix)) == FP_ZERO)
+        if (std::fpclassify(m_feedback) == FP_ZERO || std::fpclassify(m_mix.right) == FP_ZERO)
         {
             return;
         }
-        for (size_t i = 0; i < NumElements; ++i)
+        for (size_t index = 0; index < numSamples;)
         {
-            m_delay[i].processBlockInplace(target, numSamples);
+            auto subBlock = std::min(numSamples - index, MaxSubBlockSize);
+            for (size_t element = 0; element < NumElements; ++element)
+            {
+                subBlock = std::min({subBlock, m_size[element], MaxDelayLength - m_headRead[element],
+                                     MaxDelayLength - m_headWrite[element]});
+            }
+            for (size_t element = 0; element < NumElements; ++element)
+            {
+                processElement(element, target + index, subBlock);
+            }
+            index += subBlock;
         }
         std::transform(source, source + numSamples, target, target,
                        [m = m_mix](float lhs, float rhs) { return lhs * m.left + rhs * m.right; });
     }
 
   private:
-    float step(float value)
+    // like TwoLatticeAllPass::setSize
+    void setElementLength(const size_t index, const size_t length)
     {
-        auto tmp = value;
-        for (size_t i = 0; i < NumElements; ++i)
+        m_size[index] = std::clamp<size_t>(length, TwoLatticeAllPass<MaxDelayLength>::MinSize, MaxDelayLength);
+        m_headRead[index] = MaxDelayLength + m_headWrite[index] - m_size[index];
+        if (m_headRead[index] >= MaxDelayLength)
         {
-            tmp = m_delay[i].step(tmp);
+            m_headRead[index] -= MaxDelayLength;
         }
-        return value * m_mix.left + tmp * m_mix.right;
     }
+
+    template <size_t... Index>
+    static std::array<OnePoleFilter, NumElements> makeLowpasses(const float sampleRate, std::index_sequence<Index...>)
+    {
+        return {((void)Index, OnePoleFilter(sampleRate))...};
+    }
+
+    void processElement(const size_t element, float* inplace, const size_t numSamples)
+    {
+        auto* buffer = m_memory + element * MaxDelayLength;
+        latticeAllPassSegment(inplace, inplace, buffer + m_headRead[element], buffer + m_headWrite[element],
+                              m_feedback, m_lowpass[element], numSamples);
+        m_headRead[element] += numSamples;
+        m_headRead[element] = m_headRead[element] == MaxDelayLength ? 0 : m_headRead[element];
+        m_headWrite[element] += numSamples;
+        m_headWrite[element] = m_headWrite[element] == MaxDelayLength ? 0 : m_headWrite[element];
+    }
+
+    std::unique_ptr<DiffusorArena> m_ownArena; // without a shared one
+    float* m_memory;
+    float m_sampleRate;
+    float m_feedback{0.65f};
+    std::array<OnePoleFilter, NumElements> m_lowpass;
+    std::array<size_t, NumElements> m_size{};
+    std::array<size_t, NumElements> m_headRead{};
+    std::array<size_t, NumElements> m_headWrite{};
+    PanValues<float> m_mix{0.7f, 0.7f};
+};
+
+/*
+ * the diffusor chains of 2, 4 or 8 channels side by side in simd lanes
+ *
+ * Every channel has its own delay lengths, the stages of all channels run in one step per sample. The delay lines of
+ * a stage are interleaved frames of all channels written at one head, only the reads are gathered per channel. The
+ * lowpass in the delay, a recurrence per channel, becomes one vector operation for all of them.
+ * With setStageMixing the channels are mixed by a normalized hadamard matrix between the stages, like in the
+ * diffusers of a feedback delay network: each channel spreads to all others, the energy stays the same. Without it
+ * the result is the same as of a DiffusorDelayChain per channel.
+ */
+template <size_t MaxDelayLength, size_t NumStages, size_t NumChannels>
+class DiffusorNetwork
+{
+    static_assert(NumChannels == 2 || NumChannels == 4 || NumChannels == 8, "2, 4 or 8 channels");
+
+  public:
+    static constexpr size_t LaneWidth = NumChannels > 4 ? 8 : 4;
+    static constexpr size_t MaxSubBlockSize{MaxLatticeSegmentSize};
+    using Lanes = SimdFloat<LaneWidth>;
+
+    explicit DiffusorNetwork(const float sampleRate)
+        : m_sampleRate(sampleRate)
+        , m_buffer(MaxDelayLength * NumStages * NumChannels, 0.f)
+    {
+        setCutoff(8000);
+        for (auto& sizes : m_size)
+        {
+            sizes.fill(MaxDelayLength);
+        }
+    }
+
+    // like DiffusorDelayChain::setElementSize for one channel
+    void setElementSize(const size_t channel, const size_t stage, const size_t widthFor48K)
+    {
+        setElementLength(channel, stage, computeDiffusorLengths<1>({widthFor48K}, m_sampleRate, MaxDelayLength)[0]);
+    }
+
+    // all stages of all channels at once, their lengths are different primes
+    void setElementSizes(const std::array<std::array<size_t, NumStages>, NumChannels>& widthsFor48K)
+    {
+        std::array<size_t, NumStages * NumChannels> widths{};
+        for (size_t c = 0; c < NumChannels; ++c)
+        {
+            std::copy(widthsFor48K[c].begin(), widthsFor48K[c].end(), widths.begin() + c * NumStages);
+        }
+        const auto lengths = computeDiffusorLengths(widths, m_sampleRate, MaxDelayLength);
+        for (size_t c = 0; c < NumChannels; ++c)
+        {
+            for (size_t stage = 0; stage < NumStages; ++stage)
+            {
+                setElementLength(c, stage, lengths[c * NumStages + stage]);
+            }
+        }
+    }
+
+    // like OnePoleFilter::setCutoff, the same for all stages and channels
+    void setCutoff(const float hz)
+    {
+        m_pole = hz >= m_sampleRate / 2 ? 0.f : std::exp(-2.0f * 3.14159265358979f * hz / m_sampleRate);
+    }
+
+    void setMix(float mix)
+    {
+        m_mix = DSP::getMixFactor(mix);
+    }
+
+    // mixes the channels by a hadamard matrix between the stages
+    void setStageMixing(const bool enabled)
+    {
+        m_stageMixing = enabled;
+    }
+
+    // one buffer per channel, in and out may be the same buffers
+    void processBlock(const float* const* in, float* const* out, const size_t numSamples)
+    {
+        if (std::fpclassify(m_feedback) == FP_ZERO || std::fpclassify(m_mix.right) == FP_ZERO)
+        {
+            for (size_t c = 0; c < NumChannels; ++c)
+            {
+                std::copy_n(in[c], numSamples, out[c]);
+            }
+            return;
+        }
+        for (size_t index = 0; index < numSamples;)
+        {
+            auto subBlock = std::min(numSamples - index, MaxSubBlockSize);
+            for (size_t stage = 0; stage < NumStages; ++stage)
+            {
+                subBlock = std::min(subBlock, MaxDelayLength - m_headWrite[stage]);
+                for (size_t c = 0; c < NumChannels; ++c)
+                {
+                    subBlock = std::min({subBlock, m_size[stage][c], MaxDelayLength - m_headRead[stage][c]});
+                }
+            }
+            for (size_t i = 0; i < subBlock; ++i)
+            {
+                for (size_t c = 0; c < NumChannels; ++c)
+                {
+                    m_frames[i * LaneWidth + c] = in[c][index + i];
+                }
+            }
+            for (size_t stage = 0; stage < NumStages; ++stage)
+            {
+                if (m_stageMixing && stage + 1 < NumStages)
+                {
+                    processStage<true>(stage, subBlock);
+                }
+                else
+                {
+                    processStage<false>(stage, subBlock);
+                }
+            }
+            for (size_t c = 0; c < NumChannels; ++c)
+            {
+                for (size_t i = 0; i < subBlock; ++i)
+                {
+                    out[c][index + i] = in[c][index + i] * m_mix.left + m_frames[i * LaneWidth + c] * m_mix.right;
+                }
+            }
+            index += subBlock;
+        }
+    }
+
+  private:
+    void setElementLength(const size_t channel, const size_t stage, const size_t length)
+    {
+        m_size[stage][channel] = std::clamp<size_t>(length, TwoLatticeAllPass<MaxDelayLength>::MinSize, MaxDelayLength);
+        auto& headRead = m_headRead[stage][channel];
+        headRead = MaxDelayLength + m_headWrite[stage] - m_size[stage][channel];
+        if (headRead >= MaxDelayLength)
+        {
+            headRead -= MaxDelayLength;
+        }
+    }
+
+    // 1 / sqrt(NumChannels)
+    static constexpr float HadamardScale{NumChannels == 2 ? 0.70710678f : (NumChannels == 4 ? 0.5f : 0.35355339f)};
+
+    // the steps as in latticeAllPassSegment, all channels at once
+    template <bool MixChannels>
+    void processStage(const size_t stage, const size_t numSamples)
+    {
+        auto* buffer = m_buffer.data() + stage * MaxDelayLength * NumChannels;
+        std::array<const float*, NumChannels> read;
+        for (size_t c = 0; c < NumChannels; ++c)
+        {
+            read[c] = buffer + m_headRead[stage][c] * NumChannels + c;
+        }
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            for (size_t c = 0; c < NumChannels; ++c)
+            {
+                m_delayed[i * LaneWidth + c] = read[c][i * NumChannels];
+            }
+        }
+        const auto feedback = Lanes::broadcast(m_feedback);
+        const auto pole = Lanes::broadcast(m_pole);
+        auto lowpass = Lanes::load(m_lowpass[stage].data());
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto delayedValue = Lanes::load(&m_delayed[i * LaneWidth]);
+            const auto feedDelay = Lanes::load(&m_frames[i * LaneWidth]) - delayedValue * feedback;
+            auto output = feedDelay * feedback + delayedValue;
+            if constexpr (MixChannels)
+            {
+                mixChannels(output);
+            }
+            output.store(&m_frames[i * LaneWidth]);
+            lowpass = feedDelay + pole * lowpass - pole * feedDelay;
+            lowpass.store(&m_delayed[i * LaneWidth]); // now the values to write
+        }
+        lowpass.store(m_lowpass[stage].data());
+        auto* write = buffer + m_headWrite[stage] * NumChannels;
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            for (size_t c = 0; c < NumChannels; ++c)
+            {
+                write[i * NumChannels + c] = m_delayed[i * LaneWidth + c];
+            }
+        }
+
+        for (auto& headRead : m_headRead[stage])
+        {
+            headRead += numSamples;
+            headRead = headRead == MaxDelayLength ? 0 : headRead;
+        }
+        m_headWrite[stage] += numSamples;
+        m_headWrite[stage] = m_headWrite[stage] == MaxDelayLength ? 0 : m_headWrite[stage];
+    }
+
+    // fast walsh hadamard transform across the lanes
+    // (in place, an avx register passed by value without -mavx triggers a psabi warning)
+    static void mixChannels(Lanes& value)
+    {
+        butterfly<1>(value);
+        if constexpr (NumChannels > 2)
+        {
+            butterfly<2>(value);
+        }
+        if constexpr (NumChannels > 4)
+        {
+            butterfly<4>(value);
+        }
+        value *= Lanes::broadcast(HadamardScale);
+    }
+
+    // a + b in the lanes without the Distance bit, a - b in those with it
+    template <size_t Distance>
+    static void butterfly(Lanes& value)
+    {
+        Lanes sign;
+        for (size_t i = 0; i < LaneWidth; ++i)
+        {
+            sign.set(i, (i & Distance) != 0 ? -1.f : 1.f);
+        }
+        value = value.template swapLanes<Distance>() + value * sign;
+    }
+
     float m_sampleRate;
     float m_feedback{0.65f};
-    std::array<DSP::TwoLatticeAllPass<MaxDelayLength>, NumElements> m_delay;
-    std::array<size_t, NumElements> m_decayTimeInSamples{};
+    float m_pole{0.f};
+    bool m_stageMixing{false};
+    std::vector<float> m_buffer;
+    // frames of a sub-block, the unused lanes stay 0
+    std::array<float, MaxSubBlockSize * LaneWidth> m_frames{};
+    std::array<float, MaxSubBlockSize * LaneWidth> m_delayed{};
+    std::array<std::array<float, LaneWidth>, NumStages> m_lowpass{};
+    std::array<std::array<size_t, NumChannels>, NumStages> m_size{};
+    std::array<std::array<size_t, NumChannels>, NumStages> m_headRead{};
+    std::array<size_t, NumStages> m_headWrite{};
     PanValues<float> m_mix{0.7f, 0.7f};
 };
 }
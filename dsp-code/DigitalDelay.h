@@ -1,44 +1,385 @@
 #pragma once
 
+#include "AudioProcessing.h"
 #include "BufferInterpolation.h"
+#include "CpuDispatch.h"
+#include "Denormals.h"
+#include "LockFreeSlot.h"
 #include "Modulation.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
 #include <vector>
 
 
 namespace DSP
 {
 
-// a simple delay with modulation (no feedback, no taps)
-template <size_t TimeInMilliseconds>
-class DigitalDelay
+// how the ring buffer wraps: the exact size with a modulo and a copy of its start behind the end for the
+// interpolation, or a size rounded up to a power of two and a bitmask for the write and the read positions
+enum class DelayWrapping
 {
+    Modulo,
+    PowerOfTwo,
+};
+
+// the format of the samples in the ring buffer, converted when written and when read
+// Float32: exact
+// Int16: half the memory, clips at +-2 (6 dB headroom), written with a triangular dither of one step, so the noise
+// floor is below -90 dBFS whatever the signal
+// Half: ieee 754 half floats, half the memory, 11 bits of mantissa keep the noise more than 72 dB below the signal
+// (subnormals down to 6e-8, -144 dBFS)
+enum class DelayStorage
+{
+    Float32,
+    Int16,
+    Half,
+};
+
+// encode and decode a sample of the storage format, branch free so the loops are vectorized
+template <DelayStorage Storage>
+struct DelaySample;
+
+template <>
+struct DelaySample<DelayStorage::Float32>
+{
+    using Type = float;
+
+    static float encode(const float value, const uint32_t)
+    {
+        return value;
+    }
+
+    static float decode(const float value)
+    {
+        return value;
+    }
+};
+
+template <>
+struct DelaySample<DelayStorage::Int16>
+{
+    using Type = int16_t;
+    static constexpr float FullScale{2.f};
+    static constexpr float Step{FullScale / 32768.f};
+
+    // the dither comes from a hash of the sample count, not from a generator with a state that every sample depends on
+    static int16_t encode(const float value, const uint32_t count)
+    {
+        auto hash = count * 0x9e3779b1u;
+        hash ^= hash >> 15;
+        hash *= 0x85ebca77u;
+        hash ^= hash >> 13;
+        // the difference of two uniform values is triangular, within +-1 step
+        const auto dither =
+            static_cast<float>(static_cast<int32_t>(hash & 0xffffu) - static_cast<int32_t>(hash >> 16)) / 65536.f;
+        const auto scaled = std::clamp(value / Step + dither, -32768.f, 32767.f);
+        // rounded by the truncation of a positive value
+        return static_cast<int16_t>(static_cast<int32_t>(scaled + 32768.5f) - 32768);
+    }
+
+    static float decode(const int16_t value)
+    {
+        return static_cast<float>(value) * Step;
+    }
+};
+
+// the bits of a half float, converted with integer operations (no f16c or _Float16 needed) and without subnormal
+// floats, which flush to zero would lose. The magnitude is clamped to the largest half, there is no inf or nan.
+template <>
+struct DelaySample<DelayStorage::Half>
+{
+    using Type = uint16_t;
+
+    static uint16_t encode(const float value, const uint32_t)
+    {
+        const auto bits = std::bit_cast<uint32_t>(value);
+        const auto sign = (bits >> 16) & 0x8000u;
+        const auto magnitude = std::min(bits & 0x7fffffffu, 0x477fe000u); // 65504
+        // below 2^-14 the half is subnormal, adding 0.5 shifts the mantissa to its place and the fpu rounds it
+        const auto subnormal = std::bit_cast<uint32_t>(std::bit_cast<float>(magnitude) + 0.5f) - 0x3f000000u;
+        // the exponent rebiased from 127 to 15, rounded to nearest even by adding almost half a step plus the odd bit
+        const auto normal = (magnitude - (112u << 23) + 0xfffu + ((magnitude >> 13) & 1u)) >> 13;
+        return static_cast<uint16_t>((magnitude < (113u << 23) ? subnormal : normal) | sign);
+    }
+
+    static float decode(const uint16_t value)
+    {
+        const auto bits = static_cast<uint32_t>(value & 0x7fffu) << 13;
+        const auto normal = bits + (112u << 23);
+        const auto subnormal = std::bit_cast<uint32_t>(std::bit_cast<float>(bits + (113u << 23)) - 0x1p-14f);
+        const auto magnitude = (bits & 0x0f800000u) == 0 ? subnormal : normal;
+        return std::bit_cast<float>(magnitude | (static_cast<uint32_t>(value & 0x8000u) << 16));
+    }
+};
+
+// the ring buffer with one write head, read at any distance behind it
+template <DelayWrapping Wrapping, DelayStorage Storage = DelayStorage::Float32>
+class DelayBuffer
+{
+    using Sample = DelaySample<Storage>;
+
   public:
     static constexpr size_t MaxInterpolationOrder = 5;
-    explicit DigitalDelay(const float sampleRate)
+    static constexpr size_t MaxBlockSize{64};
+
+    explicit DelayBuffer(const size_t size)
+        : m_size(Wrapping == DelayWrapping::PowerOfTwo ? std::bit_ceil(size) : size)
+        , m_buffer(m_size + (Wrapping == DelayWrapping::Modulo ? MaxInterpolationOrder : 0))
+    {
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] size_t memoryInBytes() const
+    {
+        return m_buffer.size() * sizeof(typename Sample::Type);
+    }
+
+    [[nodiscard]] size_t head() const
+    {
+        return m_head;
+    }
+
+    [[nodiscard]] size_t samplesToEnd() const
+    {
+        return m_size - m_head;
+    }
+
+    // the value distance samples behind the write position head
+    [[nodiscard]] float read(const size_t head, const float distance) const
+    {
+        Points points;
+        const auto fraction = gather(head, distance, points);
+        const std::array<float, 4> values{Sample::decode(points[0]), Sample::decode(points[1]),
+                                          Sample::decode(points[2]), Sample::decode(points[3])};
+        return bspline_43z(values.data(), fraction);
+    }
+
+    // numSamples <= MaxBlockSize consecutive reads starting at head, vectorized (with gathers for avx2 and avx512)
+    // There are no gathers of 16 bits, those are gathered one by one first, then converted and interpolated.
+    void readBlock(const size_t head, const float* distances, float* target, const size_t numSamples) const
+    {
+        dispatch(
+            [&]
+            {
+                // a local array can't alias the buffer, only then the gathers are vectorized
+                std::array<float, MaxBlockSize> values;
+                if constexpr (Storage == DelayStorage::Float32)
+                {
+                    for (size_t i = 0; i < numSamples; ++i)
+                    {
+                        values[i] = read(head + i, distances[i]);
+                    }
+                }
+                else
+                {
+                    std::array<Points, MaxBlockSize> points;
+                    std::array<float, MaxBlockSize> fractions;
+                    for (size_t i = 0; i < numSamples; ++i)
+                    {
+                        fractions[i] = gather(head + i, distances[i], points[i]);
+                    }
+                    for (size_t i = 0; i < numSamples; ++i)
+                    {
+                        const std::array<float, 4> decoded{
+                            Sample::decode(points[i][0]), Sample::decode(points[i][1]),
+                            Sample::decode(points[i][2]), Sample::decode(points[i][3])};
+                        values[i] = bspline_43z(decoded.data(), fractions[i]);
+                    }
+                }
+                std::copy_n(values.begin(), numSamples, target);
+            });
+    }
+
+    // one copy (or conversion), numSamples <= samplesToEnd()
+    void write(const float* in, const size_t numSamples)
+    {
+        if constexpr (Storage == DelayStorage::Float32)
+        {
+            std::copy_n(in, numSamples, m_buffer.begin() + static_cast<ptrdiff_t>(m_head));
+            if (m_flushDenormals)
+            {
+                flushDenormals(m_buffer.data() + m_head, numSamples);
+            }
+        }
+        else
+        {
+            dispatch(
+                [&]
+                {
+                    auto* target = m_buffer.data() + m_head;
+                    for (size_t i = 0; i < numSamples; ++i)
+                    {
+                        target[i] = Sample::encode(in[i], m_written + static_cast<uint32_t>(i));
+                    }
+                });
+            m_written += static_cast<uint32_t>(numSamples);
+        }
+        if constexpr (Wrapping == DelayWrapping::PowerOfTwo)
+        {
+            m_head = (m_head + numSamples) & m_mask;
+        }
+        else
+        {
+            for (auto i = m_head; i < std::min(m_head + numSamples, MaxInterpolationOrder); ++i)
+            {
+                m_buffer[i + m_size] = m_buffer[i];
+            }
+            m_head = (m_head + numSamples) % m_size;
+        }
+    }
+
+    // the newest from.size() samples of a smaller buffer into this new one, so reads behind the head give the same
+    // values as from from, a copy without allocation, the denormal flushing is taken over as well
+    void copyHistory(const DelayBuffer& from)
+    {
+        const auto oldest = from.m_buffer.begin() + static_cast<ptrdiff_t>(from.m_head);
+        const auto end = from.m_buffer.begin() + static_cast<ptrdiff_t>(from.m_size);
+        std::copy(from.m_buffer.begin(), oldest, std::copy(oldest, end, m_buffer.begin()));
+        m_head = from.m_size;
+        if constexpr (Wrapping == DelayWrapping::Modulo)
+        {
+            std::copy_n(m_buffer.begin(), MaxInterpolationOrder, m_buffer.begin() + static_cast<ptrdiff_t>(m_size));
+        }
+        m_written = from.m_written;
+        m_flushDenormals = from.m_flushDenormals;
+    }
+
+    // tiny samples (of a feedback tail) are written as zero
+    // Only Float32 needs it, the 16 bit formats decode to no subnormal floats.
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
+    }
+
+  private:
+    using Points = std::array<typename Sample::Type, 4>;
+
+    // the 4 points around the read position and the fraction for bspline_43z
+    // The read position head - 1 - whole + (1 - fraction) of the distance is kept in integer and fraction, so it
+    // doesn't lose precision with the head as a float would, and the wrapping is done on the integer only.
+    float gather(const size_t head, const float distance, Points& points) const
+    {
+        const auto whole = static_cast<int32_t>(distance);
+        const auto fraction = 1.f - (distance - static_cast<float>(whole));
+        const auto index = static_cast<int32_t>(head) - whole - 1;
+        if constexpr (Wrapping == DelayWrapping::PowerOfTwo)
+        {
+            const auto mask = static_cast<int32_t>(m_mask);
+            points = {m_buffer[static_cast<size_t>(index & mask)], m_buffer[static_cast<size_t>((index + 1) & mask)],
+                      m_buffer[static_cast<size_t>((index + 2) & mask)],
+                      m_buffer[static_cast<size_t>((index + 3) & mask)]};
+        }
+        else
+        {
+            const auto size = static_cast<int32_t>(m_size);
+            auto wrapped = index + (index < 0 ? size : 0);
+            wrapped -= wrapped >= size ? size : 0;
+            const auto first = static_cast<size_t>(wrapped);
+            points = {m_buffer[first], m_buffer[first + 1], m_buffer[first + 2], m_buffer[first + 3]};
+        }
+        return fraction;
+    }
+
+    size_t m_size;
+    size_t m_mask{m_size - 1}; // PowerOfTwo only
+    std::vector<typename Sample::Type> m_buffer;
+    size_t m_head{0};
+    uint32_t m_written{0}; // counts the samples for the dither, wraps around
+    bool m_flushDenormals{false};
+};
+
+// how a DelayTap follows a new delay time
+// Crossfade: from the old to the new read position in 8192 samples, a change during the fade waits for its end
+// AdaptiveCrossfade: the same with a fade of twice the jump, between 256 and 8192 samples
+// Glide: the read position moves towards the new one like a tape head, smoothed and with a bounded slew rate, so the
+// pitch bends while it moves. It is read once per sample and follows every change right away.
+enum class DelayTimeChange
+{
+    Crossfade,
+    AdaptiveCrossfade,
+    Glide,
+};
+
+// a modulated read position of a DelayBuffer that follows a new delay time with a DelayTimeChange
+// A chunk is prepared first (the modulation and the delay time of each sample), then read in one block or, if
+// isBlockReadable() is false, sample by sample interleaved with the writes.
+class DelayTap
+{
+  public:
+    static constexpr size_t MaxBlockSize{64};
+    static constexpr size_t MaxFadeSamples{8192};
+    static constexpr size_t MinFadeSamples{256};
+
+    // writing a chunk before reading it gives the values of reading each sample before writing it as long as no
+    // read position falls into the part of the chunk that is not written yet by then, that is a distance above
+    // 3 samples and a distance below the buffer size minus the chunk
+    static constexpr float MinBlockDistance{4.f};
+    // the delay time is shorter than the buffer by this, room for the modulation
+    static constexpr size_t Headroom{1000};
+
+    DelayTap(const float sampleRate, const size_t bufferSize)
         : m_sampleRate(sampleRate)
-        , m_bufferSize(static_cast<size_t>(sampleRate * static_cast<float>(TimeInMilliseconds) / 1000.f))
-        , m_buffer(m_bufferSize + MaxInterpolationOrder)
-        , m_delayTime(sampleRate / 4) // 250 msecs default
+        , m_maxDelayTime(bufferSize - Headroom)
+        , m_delayTime(std::min(sampleRate / 4, static_cast<float>(m_maxDelayTime))) // 250 msecs if it fits
+        , m_glideTarget(m_delayTime)
+        , m_glideSmoothing(1.f - std::exp(-1.f / (GlideTimeConstant * sampleRate)))
         , m_modulation(sampleRate)
     {
+        for (size_t i = 0; i < m_glideDecay.size(); ++i)
+        {
+            m_glideDecay[i] = glideDecay(i + 1);
+        }
+    }
+
+    // for the following setTime calls, a running fade ends first
+    void setTimeChange(const DelayTimeChange timeChange)
+    {
+        m_timeChange = timeChange;
+    }
+
+    // the largest change of the delay time per sample while gliding, 0.5 bends the pitch by up to half an octave
+    // down and a fifth up
+    void setMaxGlideRate(const float samplesPerSample)
+    {
+        m_maxGlideRate = samplesPerSample;
     }
 
     void setTime(const float seconds)
     {
-        if (m_fadeInOut == 0)
+        const auto delayTime = static_cast<float>(
+            std::min(static_cast<size_t>(std::ceil(seconds * m_sampleRate)), m_maxDelayTime));
+        if (m_fadeInOut != 0)
         {
-            m_newDelayTime = static_cast<size_t>(ceil(seconds * m_sampleRate));
-            m_newDelayTime = std::min(static_cast<size_t>(m_newDelayTime), m_bufferSize - 1000);
-            m_fadeInOut = 8192;
-            m_fadeIn = 0.0f;
-            m_fadeOut = 1.0f;
-            m_fadeAdvance = 1.f / static_cast<float>(m_fadeInOut);
+            m_newDelayTimeScheduled = seconds;
+        }
+        else if (m_timeChange == DelayTimeChange::Glide)
+        {
+            startGlide(delayTime);
         }
         else
         {
-            m_newDelayTimeScheduled = seconds;
+            m_newDelayTime = delayTime;
+            m_fadeInOut = MaxFadeSamples;
+            if (m_timeChange == DelayTimeChange::AdaptiveCrossfade)
+            {
+                const auto jump = static_cast<size_t>(std::abs(m_newDelayTime - m_delayTime));
+                m_fadeInOut = std::clamp(jump * 2, MinFadeSamples, MaxFadeSamples);
+            }
+            m_fadeIn = 0.0f;
+            m_fadeOut = 1.0f;
+            m_fadeAdvance = 1.f / static_cast<float>(m_fadeInOut);
         }
     }
 
@@ -52,62 +393,174 @@ class DigitalDelay
         m_modulation.changeFrequency(valueInHz);
     }
 
-    float readDelayValue(float delayTime)
+    // the buffer has grown, the following setTime calls may go up to its size
+    void setBufferSize(const size_t bufferSize)
     {
-        auto mpos = m_head - m_modulation.tickSine() - delayTime;
-        if (mpos < 0)
-        {
-            mpos += m_bufferSize;
-        }
-        float readPos;
-        auto fraction = std::modf(mpos, &readPos);
-        return bspline_43z(&m_buffer[static_cast<size_t>(readPos)], fraction);
+        m_maxDelayTime = bufferSize - Headroom;
     }
 
-    float step(float inValue)
+    // a chunk ends with a crossfade
+    [[nodiscard]] size_t maxChunkSize() const
     {
-        auto fadeValue = [this]()
+        return m_fadeInOut ? std::min(MaxBlockSize, m_fadeInOut) : MaxBlockSize;
+    }
+
+    // renders the modulation and the (gliding) delay time of numSamples <= maxChunkSize()
+    void prepareChunk(const size_t numSamples)
+    {
+        m_modulation.processBlock(m_modulationValues.data(), numSamples);
+        if (m_glideTarget == m_delayTime || m_fadeInOut)
         {
-            auto result = m_fadeOut * readDelayValue(m_delayTime);
-            result += m_fadeIn * readDelayValue(m_newDelayTime);
-            m_fadeOut -= m_fadeAdvance;
-            m_fadeIn += m_fadeAdvance;
-            m_fadeInOut--;
-            if (!m_fadeInOut)
+            std::fill_n(m_delayTimes.begin(), numSamples, m_delayTime);
+            return;
+        }
+        // the glide is a function of the samples since its start, so the chunk size doesn't change it
+        const auto first = m_glideSamples + 1;
+        if (first > m_glideLinearSteps)
+        {
+            const auto remainder = m_glideRemainder * glideDecay(first - 1 - m_glideLinearSteps);
+            for (size_t i = 0; i < numSamples; ++i)
             {
-                m_delayTime = m_newDelayTime;
-                if (m_newDelayTimeScheduled != 0.f)
-                {
-                    setTime(m_newDelayTimeScheduled);
-                    m_newDelayTimeScheduled = 0.f;
-                }
+                m_delayTimes[i] = m_glideTarget - remainder * m_glideDecay[i];
             }
-            return result;
-        };
-        auto result = m_fadeInOut ? fadeValue() : readDelayValue(m_delayTime);
+        }
+        else if (first + numSamples - 1 <= m_glideLinearSteps)
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                m_delayTimes[i] = m_glideStart + m_glideSlew * static_cast<float>(first + i);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                m_delayTimes[i] = glideDelayTime(first + i);
+            }
+        }
+        m_glideSamples += numSamples;
+        m_delayTime = m_delayTimes[numSamples - 1];
+        if (std::abs(m_glideTarget - m_delayTime) < GlideSnap)
+        {
+            m_delayTime = m_glideTarget;
+        }
+    }
 
-        m_buffer[m_head] = inValue;
-        if (m_head < MaxInterpolationOrder)
+    [[nodiscard]] bool isBlockReadable(const size_t numSamples, const size_t bufferSize) const
+    {
+        const auto [lowest, highest] =
+            std::minmax_element(m_modulationValues.begin(), m_modulationValues.begin() + numSamples);
+        const auto newDelayTime = m_fadeInOut ? m_newDelayTime : m_delayTime;
+        // a glide moves monotonic from the first to the last delay time of the chunk
+        const auto first = m_delayTimes[0];
+        const auto shortest = std::min({first, m_delayTime, newDelayTime}) + *lowest;
+        const auto longest = std::max({first, m_delayTime, newDelayTime}) + *highest;
+        return shortest >= MinBlockDistance &&
+               longest <= static_cast<float>(bufferSize - numSamples) - MinBlockDistance;
+    }
+
+    // sample index of the prepared chunk, read before it is written
+    template <typename Buffer>
+    float read(const Buffer& buffer, const size_t index)
+    {
+        const auto modulation = m_modulationValues[index];
+        if (!m_fadeInOut)
         {
-            m_buffer[m_head + m_bufferSize] = inValue;
+            return buffer.read(buffer.head(), modulation + m_delayTimes[index]);
+        }
+        auto result = m_fadeOut * buffer.read(buffer.head(), modulation + m_delayTime);
+        result += m_fadeIn * buffer.read(buffer.head(), modulation + m_newDelayTime);
+        m_fadeOut -= m_fadeAdvance;
+        m_fadeIn += m_fadeAdvance;
+        m_fadeInOut--;
+        if (!m_fadeInOut)
+        {
+            finishFade();
         }
-        m_head = ++m_head % m_bufferSize;
         return result;
     }
 
-    void processBlock(const float* in, float* out, size_t numSamples)
+    // the prepared chunk of isBlockReadable() written to the buffer from head on
+    template <typename Buffer>
+    void readBlock(const Buffer& buffer, const size_t head, float* out, const size_t numSamples)
     {
+        std::array<float, MaxBlockSize> distances;
         for (size_t i = 0; i < numSamples; ++i)
         {
-            out[i] = step(in[i]);
+            distances[i] = m_modulationValues[i] + m_delayTimes[i];
+        }
+        buffer.readBlock(head, distances.data(), out, numSamples);
+        if (!m_fadeInOut)
+        {
+            return;
+        }
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            distances[i] = m_modulationValues[i] + m_newDelayTime;
+        }
+        std::array<float, MaxBlockSize> faded;
+        buffer.readBlock(head, distances.data(), faded.data(), numSamples);
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            out[i] = m_fadeOut * out[i] + m_fadeIn * faded[i];
+            m_fadeOut -= m_fadeAdvance;
+            m_fadeIn += m_fadeAdvance;
+        }
+        m_fadeInOut -= numSamples;
+        if (!m_fadeInOut)
+        {
+            finishFade();
         }
     }
 
-    float m_sampleRate;
-    size_t m_bufferSize;
-    std::vector<float> m_buffer;
+  private:
+    static constexpr float GlideTimeConstant{0.05f}; // seconds
+    static constexpr float GlideSnap{1e-3f};         // samples
 
-    size_t m_head{0};
+    // the smoothed step (target - delayTime) * smoothing is limited to the slew rate: the glide is linear until the
+    // distance to the target is below maxGlideRate / smoothing, then it decays exponentially
+    void startGlide(const float target)
+    {
+        const auto difference = target - m_delayTime;
+        const auto beyondSmoothing = std::abs(difference) - m_maxGlideRate / m_glideSmoothing;
+        m_glideTarget = target;
+        m_glideStart = m_delayTime;
+        m_glideSamples = 0;
+        m_glideSlew = std::copysign(m_maxGlideRate, difference);
+        m_glideLinearSteps =
+            beyondSmoothing > 0.f ? static_cast<size_t>(std::ceil(beyondSmoothing / m_maxGlideRate)) : 0;
+        m_glideRemainder = target - (m_glideStart + m_glideSlew * static_cast<float>(m_glideLinearSteps));
+    }
+
+    [[nodiscard]] float glideDecay(const size_t samples) const
+    {
+        return std::pow(1.f - m_glideSmoothing, static_cast<float>(samples));
+    }
+
+    // samples > 0 after the start of the glide
+    [[nodiscard]] float glideDelayTime(const size_t samples) const
+    {
+        if (samples <= m_glideLinearSteps)
+        {
+            return m_glideStart + m_glideSlew * static_cast<float>(samples);
+        }
+        return m_glideTarget - m_glideRemainder * glideDecay(samples - m_glideLinearSteps);
+    }
+
+    void finishFade()
+    {
+        m_delayTime = m_newDelayTime;
+        m_glideTarget = m_delayTime;
+        if (m_newDelayTimeScheduled != 0.f)
+        {
+            setTime(m_newDelayTimeScheduled);
+            m_newDelayTimeScheduled = 0.f;
+        }
+    }
+
+    float m_sampleRate;
+    size_t m_maxDelayTime;
+    DelayTimeChange m_timeChange{DelayTimeChange::Crossfade};
     float m_delayTime{0.f};
     float m_newDelayTime{0.f};
     float m_newDelayTimeScheduled{0.f};
@@ -115,7 +568,360 @@ class DigitalDelay
     float m_fadeIn{0.f};
     float m_fadeOut{1.f};
     float m_fadeAdvance{0.f};
+    float m_glideTarget;
+    float m_glideSmoothing;
+    float m_maxGlideRate{0.5f};
+    float m_glideStart{0.f};
+    float m_glideSlew{0.f};
+    float m_glideRemainder{0.f};
+    size_t m_glideSamples{0};
+    size_t m_glideLinearSteps{0};
     DSP::SlowSineLfo<float> m_modulation;
+    std::array<float, MaxBlockSize> m_modulationValues{};
+    std::array<float, MaxBlockSize> m_delayTimes{};
+    std::array<float, MaxBlockSize> m_glideDecay{}; // (1 - smoothing)^(i + 1)
+};
+
+template <size_t TimeInMilliseconds, DelayWrapping Wrapping, DelayStorage Storage>
+DelayBuffer<Wrapping, Storage> delayBufferFor(const float sampleRate)
+{
+    return DelayBuffer<Wrapping, Storage>(
+        static_cast<size_t>(sampleRate * static_cast<float>(TimeInMilliseconds) / 1000.f));
+}
+
+// a simple delay with modulation (no feedback, no taps)
+template <size_t TimeInMilliseconds, DelayWrapping Wrapping = DelayWrapping::Modulo,
+          DelayStorage Storage = DelayStorage::Float32>
+class DigitalDelay
+{
+  public:
+    static constexpr size_t MaxBlockSize = DelayTap::MaxBlockSize;
+
+    explicit DigitalDelay(const float sampleRate)
+        : m_buffer(delayBufferFor<TimeInMilliseconds, Wrapping, Storage>(sampleRate))
+        , m_tap(sampleRate, m_buffer.size())
+    {
+    }
+
+    // a buffer of bufferSize samples instead of TimeInMilliseconds
+    DigitalDelay(const float sampleRate, const size_t bufferSize)
+        : m_buffer(bufferSize)
+        , m_tap(sampleRate, m_buffer.size())
+    {
+    }
+
+    void setTime(const float seconds)
+    {
+        m_tap.setTime(seconds);
+    }
+
+    void setModulationDepth(const float value)
+    {
+        m_tap.setModulationDepth(value);
+    }
+
+    void setModulationSpeed(const float valueInHz)
+    {
+        m_tap.setModulationSpeed(valueInHz);
+    }
+
+    void setTimeChange(const DelayTimeChange timeChange)
+    {
+        m_tap.setTimeChange(timeChange);
+    }
+
+    // see DelayBuffer::setFlushDenormals, for a delay within a feedback loop
+    void setFlushDenormals(const bool enabled)
+    {
+        m_buffer.setFlushDenormals(enabled);
+    }
+
+    float step(const float inValue)
+    {
+        m_tap.prepareChunk(1);
+        return step(inValue, 0);
+    }
+
+    // the modulation is rendered for a chunk first, the values are written with a copy, then the reads of the chunk
+    // run in a loop of their own that is vectorized
+    // A chunk never crosses the end of the buffer or of a time change.
+    void processBlock(const float* in, float* out, size_t numSamples)
+    {
+        for (size_t index = 0; index < numSamples;)
+        {
+            const auto chunk = std::min({m_tap.maxChunkSize(), numSamples - index, m_buffer.samplesToEnd()});
+            processChunk(in + index, out + index, chunk);
+            index += chunk;
+        }
+    }
+
+    [[nodiscard]] size_t memoryInBytes() const
+    {
+        return m_buffer.memoryInBytes();
+    }
+
+    DelayBuffer<Wrapping, Storage> m_buffer;
+    DelayTap m_tap;
+
+  private:
+    // index within the prepared chunk
+    float step(const float inValue, const size_t index)
+    {
+        const auto result = m_tap.read(m_buffer, index);
+        m_buffer.write(&inValue, 1);
+        return result;
+    }
+
+    void processChunk(const float* in, float* out, const size_t numSamples)
+    {
+        m_tap.prepareChunk(numSamples);
+        if (!m_tap.isBlockReadable(numSamples, m_buffer.size()))
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                out[i] = step(in[i], i);
+            }
+            return;
+        }
+        const auto head = m_buffer.head();
+        m_buffer.write(in, numSamples);
+        m_tap.readBlock(m_buffer, head, out, numSamples);
+    }
+};
+
+/*
+ * a DigitalDelay that allocates for the delay times it is set to, up to TimeInMilliseconds
+ *
+ * It starts with InitialMilliseconds. A setTime beyond the buffer asks for a larger one and keeps the current delay
+ * time until it is there: grow(), called off the audio thread (e.g. by a timer), allocates at least twice the size,
+ * and processBlock() takes it over through a LockFreeHandover with a copy of the history the old one holds, then
+ * sets the time. grow() frees the old buffer with its next call.
+ */
+template <size_t TimeInMilliseconds, DelayWrapping Wrapping = DelayWrapping::Modulo,
+          DelayStorage Storage = DelayStorage::Float32>
+class GrowingDigitalDelay
+{
+  public:
+    static constexpr size_t InitialMilliseconds{std::min<size_t>(TimeInMilliseconds, 500)};
+    using Buffer = DelayBuffer<Wrapping, Storage>;
+
+    explicit GrowingDigitalDelay(const float sampleRate)
+        : m_sampleRate(sampleRate)
+        , m_maxSize(bufferSizeFor(TimeInMilliseconds))
+        , m_delay(sampleRate, bufferSizeFor(InitialMilliseconds))
+        , m_grownSize(m_delay.m_buffer.size())
+    {
+    }
+
+    void setTime(const float seconds)
+    {
+        const auto size =
+            std::min(static_cast<size_t>(std::ceil(seconds * m_sampleRate)) + DelayTap::Headroom, m_maxSize);
+        if (size > m_delay.m_buffer.size())
+        {
+            m_pendingTime = seconds;
+            m_requestedSize.store(size, std::memory_order_relaxed);
+            return;
+        }
+        // a longer time set before and not reached yet is abandoned, grow() must not allocate for it
+        m_pendingTime = 0.f;
+        m_requestedSize.store(0, std::memory_order_relaxed);
+        m_delay.setTime(seconds);
+    }
+
+    void setModulationDepth(const float value)
+    {
+        m_delay.setModulationDepth(value);
+    }
+
+    void setModulationSpeed(const float valueInHz)
+    {
+        m_delay.setModulationSpeed(valueInHz);
+    }
+
+    void setTimeChange(const DelayTimeChange timeChange)
+    {
+        m_delay.setTimeChange(timeChange);
+    }
+
+    // kept by the grown buffers
+    void setFlushDenormals(const bool enabled)
+    {
+        m_delay.setFlushDenormals(enabled);
+    }
+
+    void processBlock(const float* in, float* out, const size_t numSamples)
+    {
+        if (auto* grown = m_handover.take())
+        {
+            grown->copyHistory(m_delay.m_buffer);
+            std::swap(m_delay.m_buffer, *grown);
+            m_handover.giveBack();
+            m_delay.m_tap.setBufferSize(m_delay.m_buffer.size());
+            if (m_pendingTime != 0.f)
+            {
+                setTime(m_pendingTime);
+            }
+        }
+        m_delay.processBlock(in, out, numSamples);
+    }
+
+    // not on the audio thread: allocates the buffer a setTime asked for and frees the one it replaced,
+    // returns true if it allocated
+    bool grow()
+    {
+        const auto requested = m_requestedSize.load(std::memory_order_relaxed);
+        if (!m_handover.collect() || requested <= m_grownSize)
+        {
+            return false;
+        }
+        auto buffer = std::make_unique<Buffer>(std::min(std::max(requested, m_grownSize * 2), m_maxSize));
+        m_grownSize = buffer->size();
+        m_handover.offer(std::move(buffer));
+        return true;
+    }
+
+    // of the current buffer
+    [[nodiscard]] size_t memoryInBytes() const
+    {
+        return m_delay.memoryInBytes();
+    }
+
+  private:
+    [[nodiscard]] size_t bufferSizeFor(const size_t milliseconds) const
+    {
+        return static_cast<size_t>(m_sampleRate * static_cast<float>(milliseconds) / 1000.f);
+    }
+
+    float m_sampleRate;
+    size_t m_maxSize;
+    DigitalDelay<TimeInMilliseconds, Wrapping, Storage> m_delay;
+    float m_pendingTime{0.f};
+    std::atomic<size_t> m_requestedSize{0};
+    size_t m_grownSize; // of the latest buffer offered, for grow() only
+    LockFreeHandover<Buffer> m_handover;
+};
+
+/*
+ * a delay with several modulated read taps on one buffer, summed to stereo with a gain and a pan per tap
+ *
+ * Instead of one DigitalDelay per tap the buffer is allocated and written once, and a chunk is read by all taps
+ * while it is still in the cache. Each tap has its own delay time (with the crossfade of DigitalDelay on a change)
+ * and its own modulation.
+ */
+template <size_t TimeInMilliseconds, size_t NumTaps, DelayWrapping Wrapping = DelayWrapping::Modulo,
+          DelayStorage Storage = DelayStorage::Float32>
+class MultiTapDelay
+{
+  public:
+    static constexpr size_t MaxBlockSize = DelayTap::MaxBlockSize;
+
+    explicit MultiTapDelay(const float sampleRate)
+        : m_buffer(delayBufferFor<TimeInMilliseconds, Wrapping, Storage>(sampleRate))
+        , m_taps(makeTaps(sampleRate, m_buffer.size(), std::make_index_sequence<NumTaps>{}))
+    {
+        m_gains.fill(getPanFactor(0.f));
+    }
+
+    void setTime(const size_t tap, const float seconds)
+    {
+        m_taps[tap].setTime(seconds);
+    }
+
+    void setModulationDepth(const size_t tap, const float value)
+    {
+        m_taps[tap].setModulationDepth(value);
+    }
+
+    void setModulationSpeed(const size_t tap, const float valueInHz)
+    {
+        m_taps[tap].setModulationSpeed(valueInHz);
+    }
+
+    void setTimeChange(const size_t tap, const DelayTimeChange timeChange)
+    {
+        m_taps[tap].setTimeChange(timeChange);
+    }
+
+    // gain is linear, pan from -1 (left) to 1 (right)
+    void setGainAndPan(const size_t tap, const float gain, const float pan)
+    {
+        const auto factors = getPanFactor(pan);
+        m_gains[tap] = {factors.left * gain, factors.right * gain};
+    }
+
+    void processBlock(const float* in, float* left, float* right, size_t numSamples)
+    {
+        for (size_t index = 0; index < numSamples;)
+        {
+            auto chunk = std::min(numSamples - index, m_buffer.samplesToEnd());
+            for (const auto& tap : m_taps)
+            {
+                chunk = std::min(chunk, tap.maxChunkSize());
+            }
+            processChunk(in + index, left + index, right + index, chunk);
+            index += chunk;
+        }
+    }
+
+    [[nodiscard]] size_t memoryInBytes() const
+    {
+        return m_buffer.memoryInBytes();
+    }
+
+  private:
+    template <size_t... Index>
+    static std::array<DelayTap, NumTaps> makeTaps(const float sampleRate, const size_t bufferSize,
+                                                  std::index_sequence<Index...>)
+    {
+        return {((void)Index, DelayTap(sampleRate, bufferSize))...};
+    }
+
+    void processChunk(const float* in, float* left, float* right, const size_t numSamples)
+    {
+        bool blockReadable = true;
+        for (auto& tap : m_taps)
+        {
+            tap.prepareChunk(numSamples);
+            blockReadable = blockReadable && tap.isBlockReadable(numSamples, m_buffer.size());
+        }
+        if (!blockReadable)
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                left[i] = 0.f;
+                right[i] = 0.f;
+                for (size_t tap = 0; tap < NumTaps; ++tap)
+                {
+                    const auto value = m_taps[tap].read(m_buffer, i);
+                    left[i] += m_gains[tap].left * value;
+                    right[i] += m_gains[tap].right * value;
+                }
+                m_buffer.write(in + i, 1);
+            }
+            return;
+        }
+
+        const auto head = m_buffer.head();
+        m_buffer.write(in, numSamples);
+        std::fill_n(left, numSamples, 0.f);
+        std::fill_n(right, numSamples, 0.f);
+        std::array<float, MaxBlockSize> values;
+        for (size_t tap = 0; tap < NumTaps; ++tap)
+        {
+            m_taps[tap].readBlock(m_buffer, head, values.data(), numSamples);
+            const auto gains = m_gains[tap];
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                left[i] += gains.left * values[i];
+                right[i] += gains.right * values[i];
+            }
+        }
+    }
+
+    DelayBuffer<Wrapping, Storage> m_buffer;
+    std::array<DelayTap, NumTaps> m_taps;
+    std::array<PanValues<float>, NumTaps> m_gains;
 };
 
 
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+namespace DSP
+{
+
+// tan for |x| < pi / 2, relative error below 1e-5 up to 0.98 * pi / 2 (a cutoff of 0.49 * sampleRate)
+[[nodiscard]] inline float fastTan(const float x)
+{
+    // the pade approximation is precise for the half angle in [-pi / 4, pi / 4] and
+    // tan(x) = 2 * tan(x / 2) / (1 - tan(x / 2)^2), with tan(x / 2) = n / d that is 2 * n * d / (d^2 - n^2):
+    // one division and no branch, so a loop of it vectorizes
+    const auto h = x * 0.5f;
+    const auto h2 = h * h;
+    const auto n = h * (945.f - h2 * (105.f - h2));
+    const auto d = 945.f - h2 * (420.f - 15.f * h2);
+    return 2.f * n * d / ((d - n) * (d + n));
+}
+
+// sin(2 * pi * x) for a phase |x| < 2^22, absolute error below 5e-7
+[[nodiscard]] inline float fastSinCycle(const float x)
+{
+    // sin(2 v) = 2 sin(v) cos(v) with v in [-pi / 2, pi / 2] for the phase in [-0.5, 0.5], folding the phase into a
+    // quarter cycle would need a comparison, which keeps the loop from being vectorized
+    const auto t = x - static_cast<float>(static_cast<int32_t>(x + std::copysign(0.5f, x)));
+    const auto v = t * std::numbers::pi_v<float>;
+    const auto v2 = v * v;
+    // taylor series up to the 11th and the 12th power, their error at pi / 2 is below 6e-8
+    const auto s = v * (1.f + v2 * (-1.f / 6.f + v2 * (1.f / 120.f + v2 * (-1.f / 5040.f +
+                                                                          v2 * (1.f / 362880.f - v2 / 39916800.f)))));
+    const auto c = 1.f + v2 * (-1.f / 2.f + v2 * (1.f / 24.f + v2 * (-1.f / 720.f + v2 * (1.f / 40320.f +
+                                                                     v2 * (-1.f / 3628800.f + v2 / 479001600.f)))));
+    return 2.f * s * c;
+}
+
+// 2^x for |x| < 126, relative error below 3e-7
+[[nodiscard]] inline float fastExp2(const float x)
+{
+    // no libm call without sse4.1 and no branch, so a loop of it vectorizes
+    const auto rounded = static_cast<int32_t>(x + std::copysign(0.5f, x));
+    const auto f = x - static_cast<float>(rounded);                           // [-0.5, 0.5]
+    // taylor series of 2^f = e^(f * ln 2) up to the 6th power
+    constexpr auto c1 = std::numbers::ln2_v<float>;
+    constexpr auto c2 = c1 * c1 / 2;
+    constexpr auto c3 = c2 * c1 / 3;
+    constexpr auto c4 = c3 * c1 / 4;
+    constexpr auto c5 = c4 * c1 / 5;
+    constexpr auto c6 = c5 * c1 / 6;
+    const auto p = 1.f + f * (c1 + f * (c2 + f * (c3 + f * (c4 + f * (c5 + f * c6)))));
+    // the integer part goes straight into the exponent bits
+    const auto exponent = static_cast<uint32_t>(rounded + 127) << 23;
+    return p * std::bit_cast<float>(exponent);
+}
+
+// e^x, relative error below 1e-6 for |x| < 8 and below 1e-5 up to |x| < 87 (x * log2(e) is rounded)
+[[nodiscard]] inline float fastExp(const float x)
+{
+    return fastExp2(x * std::numbers::log2e_v<float>);
+}
+
+// 10^x for |x| < 4 (+-80 dB as gain), relative error below 1e-6
+[[nodiscard]] inline float fastPow10(const float x)
+{
+    constexpr auto log2Of10 = static_cast<float>(std::numbers::ln10 / std::numbers::ln2);
+    return fastExp2(x * log2Of10);
+}
+
+// the functions the coefficient computations need, selected by CoefficientMath
+struct ExactMathFunctions
+{
+    static float tan(const float x)
+    {
+        return std::tan(x);
+    }
+
+    static float pow10(const float x)
+    {
+        return std::pow(10.f, x);
+    }
+};
+
+struct FastMathFunctions
+{
+    static float tan(const float x)
+    {
+        return fastTan(x);
+    }
+
+    static float pow10(const float x)
+    {
+        return fastPow10(x);
+    }
+};
+
+enum class CoefficientMath
+{
+    Exact, // std::tan and std::pow
+    Fast,  // fastTan and fastPow10
+};
+}
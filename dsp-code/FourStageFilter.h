@@ -8,9 +8,13 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <utility>
 
 #include "AudioProcessing.h"
+#include "FastMath.h"
 #include "OnePoleFilter.h"
+#include "Oversampling.h"
+#include "Simd.h"
 
 namespace DSP
 {
@@ -99,6 +103,223 @@ class MultiModeFourPoleMixerModule
 };
 
 
+/*
+ * MultiModeFourPoleMixerModule without the unit delay in the resonance path: the stages are trapezoidal (tpt) one
+ * poles and the feedback is solved for the current sample (zero delay feedback), so the cutoff stays in tune at high
+ * resonance. It runs at Oversampling times the sample rate with the up- and downsampling only around this filter,
+ * the rest of the chain stays at the sample rate.
+ *
+ * The filter is linear (instead of the hard clamp the resonance stays just below self oscillation), so one sample is
+ * a 4x4 matrix applied to the four stage states plus the input. The matrix is taken from the tpt step whenever a
+ * parameter changes and the per sample chain shrinks to a SimdFloat<4> multiply-add.
+ */
+template <size_t Oversampling>
+class ZdfFourPoleMixerModule
+{
+    using State = SimdFloat<4>;
+
+  public:
+    explicit ZdfFourPoleMixerModule(const float sampleRate)
+        : m_sampleRate(sampleRate * static_cast<float>(Oversampling))
+    {
+        setCutoff(1000.f);
+    }
+
+    void setCutoff(const float cutoff)
+    {
+        const auto g = std::tan(static_cast<float>(M_PI) * std::min(cutoff, m_sampleRate * 0.49f) / m_sampleRate);
+        m_gain = g / (1.f + g);
+        updateStateSpace();
+    }
+
+    void setResonance(const float resonanceNormalized)
+    {
+        m_resonance = std::min(resonanceNormalized, MaxResonance) * 4.f;
+        updateStateSpace();
+    }
+
+    void setFactors(const std::array<float, 5>& values)
+    {
+        m_factors = values;
+        updateStateSpace();
+    }
+
+    void setFactors(const std::array<int, 5>& values)
+    {
+        std::transform(values.begin(), values.end(), m_factors.begin(), [](int i) { return static_cast<float>(i); });
+        updateStateSpace();
+    }
+
+    void reset()
+    {
+        m_state = State::zero();
+        m_oversampler.reset();
+    }
+
+    void processBlock(float* inPlace, size_t numSamples)
+    {
+        processBlock(inPlace, inPlace, numSamples);
+    }
+
+    // audio rate modulation, a cutoff in Hz for every sample, held for the oversampled ones
+    // The matrices would have to be recomputed for every sample, so the step is solved with a gain from fastTan on
+    // the four stages at once. The last cutoff stays for the processBlock calls without a cutoff buffer.
+    void processBlock(const float* in, const float* cutoffHz, float* out, size_t numSamples)
+    {
+        constexpr auto chunkSize = Oversampler<Oversampling>::MaxBlockSize;
+        const auto scale = static_cast<float>(M_PI) / m_sampleRate;
+        const auto maxCutoff = m_sampleRate * 0.49f;
+        for (size_t index = 0; index < numSamples; index += chunkSize)
+        {
+            const auto chunk = std::min(chunkSize, numSamples - index);
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                const auto g = fastTan(scale * std::min(std::max(cutoffHz[index + i], 0.f), maxCutoff));
+                const auto gain = g / (1.f + g);
+                m_modulatedGains[i] = gain;
+                m_modulatedFeedbackScales[i] = feedbackScale(gain);
+            }
+            m_oversampler.upsample(in + index, m_oversampled.data(), chunk);
+            auto state = m_state;
+            for (size_t i = 0; i < chunk * Oversampling; ++i)
+            {
+                const auto j = i / Oversampling;
+                m_oversampled[i] =
+                    modulatedStep(state, m_oversampled[i], m_modulatedGains[j], m_modulatedFeedbackScales[j]);
+            }
+            m_state = state;
+            m_oversampler.downsample(m_oversampled.data(), out + index, chunk);
+            m_gain = m_modulatedGains[chunk - 1];
+        }
+        updateStateSpace();
+    }
+
+    void processBlock(const float* in, float* out, size_t numSamples)
+    {
+        constexpr auto chunkSize = Oversampler<Oversampling>::MaxBlockSize;
+        for (size_t index = 0; index < numSamples; index += chunkSize)
+        {
+            const auto chunk = std::min(chunkSize, numSamples - index);
+            m_oversampler.upsample(in + index, m_oversampled.data(), chunk);
+            auto state = m_state;
+            for (size_t i = 0; i < chunk * Oversampling; ++i)
+            {
+                const auto x = m_oversampled[i];
+                m_oversampled[i] = (m_output * state).sum() + m_outputFromInput * x;
+                state = (m_transition[0] * State::broadcast(state[0]) + m_transition[1] * State::broadcast(state[1])) +
+                        (m_transition[2] * State::broadcast(state[2]) + m_transition[3] * State::broadcast(state[3])) +
+                        m_input * State::broadcast(x);
+            }
+            m_state = state;
+            m_oversampler.downsample(m_oversampled.data(), out + index, chunk);
+        }
+    }
+
+  private:
+    static constexpr float MaxResonance{0.99f};
+
+    // one sample of the four tpt stages, a stage is y = G * x + (1 - G) * s, so the fourth one is G^4 * feed + the
+    // sum of the states passed through the later stages, with feed = in - k * y4 this is solved for y4 first
+    // feedbackScale is 1 / (1 + k * G^4)
+    float tptStep(std::array<float, 4>& s, const float in, const float g, const float scale) const
+    {
+        const auto g4 = g * g * g * g;
+        const auto stateSum = (1.f - g) * (((s[0] * g + s[1]) * g + s[2]) * g + s[3]);
+        const auto stage4 = (g4 * in + stateSum) * scale;
+        const auto feed = in - m_resonance * stage4;
+
+        std::array<float, 4> y;
+        auto x = feed;
+        for (size_t i = 0; i < y.size(); ++i)
+        {
+            const auto v = (x - s[i]) * g;
+            y[i] = v + s[i];
+            s[i] = y[i] + v;
+            x = y[i];
+        }
+
+        float result = feed * m_factors[0];
+        result -= y[0] * m_factors[1];
+        result += y[1] * m_factors[2];
+        result -= y[2] * m_factors[3];
+        result += y[3] * m_factors[4];
+        return result;
+    }
+
+    // tptStep on the stages as lanes: with the powers p = (1, G, G^2, G^3) the part of the states in stage i is
+    // (1 - G) * sum over j <= i of G^(i - j) * s[j] and the part of the input G^(i + 1) * feed
+    // The powers don't depend on the state, so only the feedback and a few lane operations are left in the chain.
+    float modulatedStep(State& s, const float in, const float g, const float scale) const
+    {
+        State powers;
+        powers.set(0, 1.f);
+        powers.set(1, g);
+        powers.set(2, g * g);
+        powers.set(3, g * g * g);
+        const auto fromStates =
+            State::broadcast(1.f - g) *
+            ((powers * State::broadcast(s[0]) + powers.shiftUp<1>() * State::broadcast(s[1])) +
+             (powers.shiftUp<2>() * State::broadcast(s[2]) + powers.shiftUp<3>() * State::broadcast(s[3])));
+        const auto stage4 = (g * powers[3] * in + fromStates[3]) * scale;
+        const auto feed = in - m_resonance * stage4;
+        const auto y = powers * State::broadcast(g * feed) + fromStates;
+        s = y + y - s;
+        return feed * m_factors[0] + (m_modulatedMix * y).sum();
+    }
+
+    float feedbackScale(const float g) const
+    {
+        return 1.f / (1.f + m_resonance * g * g * g * g);
+    }
+
+    // the step is linear in the states and the input, so a unit state or input gives a column of the matrices
+    void updateStateSpace()
+    {
+        for (size_t j = 0; j < 4; ++j)
+        {
+            std::array<float, 4> unit{};
+            unit[j] = 1.f;
+            m_output.set(j, tptStep(unit, 0.f, m_gain, feedbackScale(m_gain)));
+            m_transition[j] = State::load(unit.data());
+        }
+        std::array<float, 4> zero{};
+        m_outputFromInput = tptStep(zero, 1.f, m_gain, feedbackScale(m_gain));
+        m_input = State::load(zero.data());
+        const std::array<float, 4> mix{-m_factors[1], m_factors[2], -m_factors[3], m_factors[4]};
+        m_modulatedMix = State::load(mix.data());
+    }
+
+    float m_sampleRate;
+    float m_gain{0};
+    float m_resonance{0};
+    std::array<float, 5> m_factors{0, 0, 0, 0, 1}; // lowpass 24
+
+    std::array<State, 4> m_transition{};
+    State m_input{State::zero()};
+    State m_output{State::zero()};
+    float m_outputFromInput{0};
+    State m_modulatedMix{State::zero()};
+    State m_state{State::zero()};
+
+    Oversampler<Oversampling> m_oversampler;
+    std::array<float, Oversampler<Oversampling>::MaxBlockSize * Oversampling> m_oversampled{};
+    std::array<float, Oversampler<Oversampling>::MaxBlockSize> m_modulatedGains{};
+    std::array<float, Oversampler<Oversampling>::MaxBlockSize> m_modulatedFeedbackScales{};
+};
+
+
+// how the pole moves within the samples processed: not, towards a new cutoff or following a cutoff per sample
+enum class FourStagePole
+{
+    Fixed,
+    Smoothed,
+    Modulated,
+};
+
+// the smoothed cutoff, the four stages and the block loop shared by the four stage filters
+// Derived provides float mix(float feed, const std::array<float, 4>& stages), it is called without a virtual dispatch
+// so the whole loop is inlined. A derived class may also provide its own processSamples for a range of samples.
+template <typename Derived>
 class FourStageFilter
 {
   public:
@@ -141,13 +362,40 @@ class FourStageFilter
         return m_pole;
     }
 
-    virtual float singleStep(float in) = 0;
+    float singleStep(const float in)
+    {
+        const auto feed = feedStages(m_v, m_pole, m_reso, in);
+        return derived().mix(feed, m_v);
+    }
 
     void processBlock(float* source, size_t numSamples)
     {
         processBlock(source, source, numSamples);
     }
 
+    // audio rate modulation, a cutoff in Hz for every sample
+    // The poles of a chunk are computed with fastExp in one vectorizable loop, the smoothing is not needed then.
+    // The last cutoff stays for the processBlock calls without a cutoff buffer.
+    void processBlock(const float* source, const float* cutoffHz, float* target, size_t numSamples)
+    {
+        const auto scale = -2.0f * static_cast<float>(M_PI) / m_sampleRate;
+        const auto nyquist = m_sampleRate * 0.5f;
+        for (size_t index = 0; index < numSamples; index += ModulationChunkSize)
+        {
+            const auto chunk = std::min(ModulationChunkSize, numSamples - index);
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                m_modulatedPoles[i] = fastExp(scale * std::min(std::max(cutoffHz[index + i], 0.f), nyquist));
+            }
+            derived().template processSamples<FourStagePole::Modulated>(source + index, target + index, 0, chunk);
+        }
+        if (numSamples > 0)
+        {
+            m_newpole = m_pole;
+            m_stepsadvance = 0;
+        }
+    }
+
     void processBlock(const float* source, float* target, size_t numSamples)
     {
         size_t index = 0;
@@ -165,25 +413,79 @@ class FourStageFilter
             {
                 m_stepsadvance -= numSamples;
             }
-            while (index < toIndex)
-            {
-                m_pole += m_advance;
-                target[index] = singleStep(source[index]);
-                ++index;
-            }
+            derived().template processSamples<FourStagePole::Smoothed>(source, target, index, toIndex);
+            index = toIndex;
             if (!m_stepsadvance)
             {
                 m_pole = m_newpole;
             }
         }
-        while (index < numSamples)
+        derived().template processSamples<FourStagePole::Fixed>(source, target, index, numSamples);
+    }
+
+    // samples from .. to - 1
+    template <FourStagePole Pole>
+    void processSamples(const float* source, float* target, const size_t from, const size_t to)
+    {
+        processStages<Pole>(source, target, from, to,
+                                 [this](const float feed, const std::array<float, 4>& v)
+                                 { return derived().mix(feed, v); });
+    }
+
+  protected:
+    // the state lives in locals during the loop, the writes to target could alias the members otherwise
+    template <FourStagePole Pole, typename Mix>
+    void processStages(const float* source, float* target, const size_t from, const size_t to, Mix&& mix)
+    {
+        auto v = m_v;
+        auto pole = m_pole;
+        const auto reso = m_reso;
+        const auto advance = m_advance;
+        for (size_t i = from; i < to; ++i)
         {
-            target[index] = singleStep(source[index]);
-            ++index;
+            if constexpr (Pole == FourStagePole::Smoothed)
+            {
+                pole += advance;
+            }
+            else if constexpr (Pole == FourStagePole::Modulated)
+            {
+                pole = m_modulatedPoles[i];
+            }
+            const auto feed = feedStages(v, pole, reso, source[i]);
+            target[i] = mix(feed, v);
         }
+        m_v = v;
+        m_pole = pole;
+    }
+
+    // the four one pole stages with the resonance feedback, the mix of feed and stages is the output
+    // written as (1 - pole) * input + pole * state, the products with the previous states don't wait for the stage
+    // before, so a sample only waits for one multiply and add per stage
+    static float feedStages(std::array<float, 4>& v, const float pole, const float reso, const float in)
+    {
+        const auto gain = 1.f - pole;
+        const auto feed = in - v[3] * reso;
+        v[0] = gain * feed + pole * v[0];
+        v[1] = gain * v[0] + pole * v[1];
+        v[2] = gain * v[1] + pole * v[2];
+        v[3] = gain * v[2] + pole * v[3];
+        return feed;
+    }
+
+    static float mixStages(const std::array<float, 5>& f, const float feed, const std::array<float, 4>& v)
+    {
+        return f[0] * feed + f[1] * v[0] + f[2] * v[1] + f[3] * v[2] + f[4] * v[3];
     }
 
   private:
+    static constexpr size_t ModulationChunkSize{64};
+
+    Derived& derived()
+    {
+        return static_cast<Derived&>(*this);
+    }
+
+    std::array<float, ModulationChunkSize> m_modulatedPoles{};
     float m_sampleRate;
     float m_advance{0};
     size_t m_stepsadvance{0};
@@ -198,27 +500,21 @@ class FourStageFilter
 
 
 template <std::array<float, 5> f>
-class FourStageMultiFilter : public FourStageFilter
+class FourStageMultiFilter : public FourStageFilter<FourStageMultiFilter<f>>
 {
   public:
     explicit FourStageMultiFilter(const float sampleRate)
-        : FourStageFilter(sampleRate, 1000.0)
+        : FourStageFilter<FourStageMultiFilter<f>>(sampleRate, 1000.0)
     {
     }
 
-    float singleStep(const float in) final
+    float mix(const float feed, const std::array<float, 4>& v) const
     {
-        auto feed = in - m_v[3] * m_reso;
-        m_v[0] = feed + m_pole * (m_v[0] - feed);
-        m_v[1] = m_v[0] + m_pole * (m_v[1] - m_v[0]);
-        m_v[2] = m_v[1] + m_pole * (m_v[2] - m_v[1]);
-        m_v[3] = m_v[2] + m_pole * (m_v[3] - m_v[2]);
-        auto tmpSum = f[0] * feed + f[1] * m_v[0] + f[2] * m_v[1] + f[3] * m_v[2] + f[4] * m_v[3];
-        return tmpSum;
+        return FourStageMultiFilter::mixStages(f, feed, v);
     }
 };
 
-class VariableFilter1Pole4StageSmooth : public FourStageFilter
+class VariableFilter1Pole4StageSmooth : public FourStageFilter<VariableFilter1Pole4StageSmooth>
 {
   public:
     explicit VariableFilter1Pole4StageSmooth(const float sampleRate)
@@ -226,16 +522,18 @@ class VariableFilter1Pole4StageSmooth : public FourStageFilter
     {
     }
 
-    float singleStep(const float in) final
+    float mix(const float feed, const std::array<float, 4>& v) const
+    {
+        return mixStages(m_factors, feed, v);
+    }
+
+    template <FourStagePole Pole>
+    void processSamples(const float* source, float* target, const size_t from, const size_t to)
     {
-        auto feed = in - m_v[3] * m_reso;
-        m_v[0] = feed + m_pole * (m_v[0] - feed);
-        m_v[1] = m_v[0] + m_pole * (m_v[1] - m_v[0]);
-        m_v[2] = m_v[1] + m_pole * (m_v[2] - m_v[1]);
-        m_v[3] = m_v[2] + m_pole * (m_v[3] - m_v[2]);
-        auto tmpSum = m_factors[0] * feed + m_factors[1] * m_v[0] + m_factors[2] * m_v[1] + m_factors[3] * m_v[2] +
-                      m_factors[4] * m_v[3];
-        return tmpSum;
+        const auto factors = m_factors;
+        processStages<Pole>(source, target, from, to,
+                                 [&factors](const float feed, const std::array<float, 4>& v)
+                                 { return mixStages(factors, feed, v); });
     }
 
     void setFactors(const std::array<float, 5>& values)
@@ -295,4 +593,138 @@ using Hp12Lp6Smooth = FourStageMultiFilter<MultiModeHp12Lp6>;
 using Hp18Lp6Smooth = FourStageMultiFilter<MultiModeHp18Lp6>;
 using Notch12Lp6Smooth = FourStageMultiFilter<MultiModeNotch12Lp6>;
 using Allpass18Lp6Smooth = FourStageMultiFilter<MultiModeAllpass18Lp6>;
+
+enum class FourStageMode
+{
+    Lp6,
+    Lp12,
+    Lp18,
+    Lp24,
+    Bp6,
+    Bp12,
+    Hp6,
+    Hp12,
+    Hp18,
+    Hp24,
+    Phaser12,
+    Phaser24,
+    DoubleNotch,
+    Notch12,
+    Hp12Lp6,
+    Hp18Lp6,
+    Notch12Lp6,
+    Allpass18Lp6,
+};
+
+// indexed by FourStageMode
+inline constexpr std::array<std::array<float, 5>, 18> FourStageModeFactors{
+    MultiModeLp6,      MultiModeLp12,       MultiModeLp18,         MultiModeLp24,    MultiModeBp6,
+    MultiModeBp12,     MultiModeHp6,        MultiModeHp12,         MultiModeHp18,    MultiModeHp24,
+    MultiModePhaser12, MultiModePhaser24,   MultiModeDoubleNotch,  MultiModeNotch12, MultiModeHp12Lp6,
+    MultiModeHp18Lp6,  MultiModeNotch12Lp6, MultiModeAllpass18Lp6};
+
+// all modes of FourStageMultiFilter in one filter, the mode can be switched at runtime
+// The mode is dispatched once per block to a loop with the factors as constants. All modes share the four stages,
+// so a switch crossfades the factors of the mixer while the stages keep running.
+class FourStageMultiModeFilter : public FourStageFilter<FourStageMultiModeFilter>
+{
+  public:
+    explicit FourStageMultiModeFilter(const float sampleRate, const FourStageMode mode = FourStageMode::Lp24)
+        : FourStageFilter(sampleRate, 1000.0)
+        , m_mode(mode)
+        , m_factors(FourStageModeFactors[static_cast<size_t>(mode)])
+    {
+    }
+
+    // 0 switches with the next sample
+    void setModeFadeSteps(const size_t steps)
+    {
+        m_fadeStepsSetting = steps;
+    }
+
+    void setMode(const FourStageMode mode)
+    {
+        m_mode = mode;
+        const auto& target = FourStageModeFactors[static_cast<size_t>(mode)];
+        m_fadeSteps = m_fadeStepsSetting;
+        if (m_fadeSteps == 0)
+        {
+            m_factors = target;
+            return;
+        }
+        // from the factors reached so far, a switch during a fade is smooth as well
+        for (size_t i = 0; i < m_factors.size(); ++i)
+        {
+            m_factorsAdvance[i] = (target[i] - m_factors[i]) / static_cast<float>(m_fadeSteps);
+        }
+    }
+
+    [[nodiscard]] FourStageMode mode() const
+    {
+        return m_mode;
+    }
+
+    float mix(const float feed, const std::array<float, 4>& v) const
+    {
+        return mixStages(m_factors, feed, v);
+    }
+
+    template <FourStagePole Pole>
+    void processSamples(const float* source, float* target, size_t from, const size_t to)
+    {
+        if (m_fadeSteps > 0)
+        {
+            const auto fadeTo = std::min(to, from + m_fadeSteps);
+            m_fadeSteps -= fadeTo - from;
+            auto factors = m_factors;
+            const auto advance = m_factorsAdvance;
+            processStages<Pole>(source, target, from, fadeTo,
+                                     [&factors, &advance](const float feed, const std::array<float, 4>& v)
+                                     {
+                                         for (size_t f = 0; f < factors.size(); ++f)
+                                         {
+                                             factors[f] += advance[f];
+                                         }
+                                         return mixStages(factors, feed, v);
+                                     });
+            m_factors = m_fadeSteps > 0 ? factors : FourStageModeFactors[static_cast<size_t>(m_mode)];
+            from = fadeTo;
+        }
+        // a static member would need the complete class, the table is built here at compile time as well
+        static constexpr auto Kernels = makeKernels(std::make_index_sequence<FourStageModeFactors.size()>{});
+        (this->*Kernels[static_cast<size_t>(m_mode)][static_cast<size_t>(Pole)])(source, target, from, to);
+    }
+
+  private:
+    using Kernel = void (FourStageMultiModeFilter::*)(const float*, float*, size_t, size_t);
+
+    template <FourStageMode Mode, FourStagePole Pole>
+    void processMode(const float* source, float* target, const size_t from, const size_t to)
+    {
+        processStages<Pole>(source, target, from, to,
+                                 [](const float feed, const std::array<float, 4>& v)
+                                 { return mixStages(FourStageModeFactors[static_cast<size_t>(Mode)], feed, v); });
+    }
+
+    // indexed by FourStagePole
+    template <FourStageMode Mode>
+    static constexpr std::array<Kernel, 3> kernelsOf()
+    {
+        return {&FourStageMultiModeFilter::processMode<Mode, FourStagePole::Fixed>,
+                &FourStageMultiModeFilter::processMode<Mode, FourStagePole::Smoothed>,
+                &FourStageMultiModeFilter::processMode<Mode, FourStagePole::Modulated>};
+    }
+
+    template <size_t... Mode>
+    static constexpr std::array<std::array<Kernel, 3>, sizeof...(Mode)> makeKernels(std::index_sequence<Mode...>)
+    {
+        return {kernelsOf<static_cast<FourStageMode>(Mode)>()...};
+    }
+
+    FourStageMode m_mode;
+    std::array<float, 5> m_factors;
+    std::array<float, 5> m_factorsAdvance{};
+    size_t m_fadeSteps{0};
+    size_t m_fadeStepsSetting{256u};
+};
 }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace DSP
+{
+
+/*
+ * hands values from one writer thread to one reader thread without locks (a triple buffer)
+ *
+ * The writer and the reader own one buffer each, the third one is shared. push() fills the writer buffer and
+ * exchanges it with the shared one, pull() exchanges the reader buffer with the shared one if it holds new data.
+ * Neither side ever waits and the reader always gets the latest complete value, intermediate ones may be skipped.
+ */
+template <typename T>
+class LockFreeSlot
+{
+  public:
+    // writer side
+    void push(const T& value)
+    {
+        m_buffers[m_writeIndex] = value;
+        const auto shared = static_cast<uint8_t>(m_writeIndex | NewData);
+        const auto previous = m_shared.exchange(shared, std::memory_order_acq_rel);
+        m_writeIndex = previous & IndexMask;
+    }
+
+    // reader side, returns false and leaves value untouched if nothing was pushed since the last pull
+    bool pull(T& value)
+    {
+        if ((m_shared.load(std::memory_order_relaxed) & NewData) == 0)
+        {
+            return false;
+        }
+        const auto previous = m_shared.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & IndexMask;
+        value = m_buffers[m_readIndex];
+        return true;
+    }
+
+  private:
+    static constexpr uint8_t IndexMask = 3;
+    static constexpr uint8_t NewData = 4;
+
+    std::array<T, 3> m_buffers{};
+    uint8_t m_writeIndex{0};
+    uint8_t m_readIndex{1};
+    std::atomic<uint8_t> m_shared{2};
+};
+
+/*
+ * hands a heap object from a writer thread to a reader thread and back without locks, so the reader (the audio
+ * thread) neither allocates nor frees
+ *
+ * One object is on its way at a time: the writer offers it, the reader takes it over (e.g. swaps its contents)
+ * and gives it back, the writer frees it with the next collect(). The states go Idle -> Offered (writer)
+ * -> Returned (reader) -> Idle (writer), the object belongs to the side that may change the state.
+ */
+template <typename T>
+class LockFreeHandover
+{
+  public:
+    // writer side, frees an object that was given back, returns false while an offer is pending
+    bool collect()
+    {
+        const auto state = m_state.load(std::memory_order_acquire);
+        if (state == State::Returned)
+        {
+            m_object.reset();
+            m_state.store(State::Idle, std::memory_order_release);
+        }
+        return state != State::Offered;
+    }
+
+    // writer side, only after collect() returned true
+    void offer(std::unique_ptr<T> object)
+    {
+        m_object = std::move(object);
+        m_state.store(State::Offered, std::memory_order_release);
+    }
+
+    // reader side, the offered object or nullptr
+    T* take()
+    {
+        return m_state.load(std::memory_order_acquire) == State::Offered ? m_object.get() : nullptr;
+    }
+
+    // reader side, done with the object of take()
+    void giveBack()
+    {
+        m_state.store(State::Returned, std::memory_order_release);
+    }
+
+  private:
+    enum class State : uint8_t
+    {
+        Idle,
+        Offered,
+        Returned,
+    };
+
+    std::unique_ptr<T> m_object;
+    std::atomic<State> m_state{State::Idle};
+};
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 
+#include "FastMath.h"
+
 #include <algorithm>
+#include <array>
 #include <cmath>
 
 namespace DSP
@@ -152,19 +155,7 @@ class SlowSineLfo
 
     void tick()
     {
-        if (amplitudeChangeSteps)
-        {
-            currentAmplitude += amplitudeAdvance;
-            if (!--amplitudeChangeSteps)
-            {
-                currentAmplitude = targetAmplitude;
-            }
-        }
-        phase += m_advance;
-        if (phase >= 1.0)
-        {
-            phase -= 1.0;
-        }
+        advance();
         lastValue = static_cast<float>(std::sin(phase * M_PI * 2) * currentAmplitude);
     }
 
@@ -175,12 +166,48 @@ class SlowSineLfo
         return lastSine();
     }
 
+    // the phases and amplitudes first, then the sines in a loop of their own that vectorizes
+    // fastSinCycle instead of std::sin, the values differ from tickSine by less than 1e-6 * amplitude
     void processBlock(T* target, size_t numSamples)
     {
-        std::generate_n(target, numSamples, [this]() { return tickSine(); });
+        constexpr size_t chunkSize{64};
+        std::array<float, chunkSize> phases;
+        std::array<T, chunkSize> amplitudes;
+        for (size_t index = 0; index < numSamples; index += chunkSize)
+        {
+            const auto chunk = std::min(chunkSize, numSamples - index);
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                advance();
+                phases[i] = static_cast<float>(phase);
+                amplitudes[i] = currentAmplitude;
+            }
+            for (size_t i = 0; i < chunk; ++i)
+            {
+                target[index + i] = static_cast<T>(fastSinCycle(phases[i])) * amplitudes[i];
+            }
+            lastValue = target[index + chunk - 1];
+        }
     }
 
   private:
+    void advance()
+    {
+        if (amplitudeChangeSteps)
+        {
+            currentAmplitude += amplitudeAdvance;
+            if (!--amplitudeChangeSteps)
+            {
+                currentAmplitude = targetAmplitude;
+            }
+        }
+        phase += m_advance;
+        if (phase >= 1.0)
+        {
+            phase -= 1.0;
+        }
+    }
+
     T m_sampleRate;
     double phase{0.f};
     double m_advance{0.00001f};
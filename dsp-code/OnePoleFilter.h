@@ -1,5 +1,9 @@
 #pragma once
 
+#include "CpuDispatch.h"
+#include "Denormals.h"
+#include "Simd.h"
+
 #include <algorithm>
 #include <array>
 #include <cmath>
@@ -30,10 +34,7 @@ class OnePoleFilter
 
     void processBlock(float* inPlace, size_t numSamples)
     {
-        for (size_t i = 0; i < numSamples; ++i)
-        {
-            inPlace[i] = next(inPlace[i]);
-        }
+        processBlock(inPlace, inPlace, numSamples);
     }
 
     void processBlock(const float* in, float* out, size_t numSamples)
@@ -42,6 +43,21 @@ class OnePoleFilter
         {
             out[i] = next(in[i]);
         }
+        if (m_flushDenormals)
+        {
+            flushDenormalState();
+        }
+    }
+
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
+    }
+
+    // for callers of next()
+    void flushDenormalState()
+    {
+        m_v = flushDenormal(m_v);
     }
 
     void setCutoff(const float cutoff)
@@ -63,6 +79,7 @@ class OnePoleFilter
     float m_sampleRate;
     float m_fdbk{0};
     float m_v{0};
+    bool m_flushDenormals{false};
 };
 
 class OnePoleFilterOptimized
@@ -88,20 +105,55 @@ class OnePoleFilterOptimized
 
     void processBlock(float* inPlace, size_t numSamples)
     {
-        for (size_t i = 0; i < numSamples; ++i)
-        {
-            inPlace[i] = next(inPlace[i]);
-        }
+        processBlock(inPlace, inPlace, numSamples);
     }
 
+    // y = fdbk * y' + (1 - fdbk) * x for ScanLanes samples at once: a prefix scan within the register, the last
+    // output of the previous step enters with the powers of fdbk
     void processBlock(const float* in, float* out, size_t numSamples)
     {
-        for (size_t i = 0; i < numSamples; ++i)
+        dispatch(
+            [&]
+            {
+                using Vector = SimdFloat<ScanLanes>;
+                const auto gain = Vector::broadcast(1.f - m_fdbk);
+                const auto pole = Vector::broadcast(m_powers[0]);
+                const auto pole2 = Vector::broadcast(m_powers[1]);
+                const auto pole4 = Vector::broadcast(m_powers[3]);
+                const auto powers = Vector::load(m_powers.data());
+                size_t i = 0;
+                for (; i + ScanLanes <= numSamples; i += ScanLanes)
+                {
+                    auto y = gain * Vector::load(in + i);
+                    y += pole * y.template shiftUp<1>();
+                    y += pole2 * y.template shiftUp<2>();
+                    y += pole4 * y.template shiftUp<4>();
+                    y += powers * Vector::broadcast(m_v);
+                    y.store(out + i);
+                    m_v = y[ScanLanes - 1];
+                }
+                for (; i < numSamples; ++i)
+                {
+                    out[i] = next(in[i]);
+                }
+            });
+        if (m_flushDenormals)
         {
-            out[i] = next(in[i]);
+            flushDenormalState();
         }
     }
 
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
+    }
+
+    // for callers of next()
+    void flushDenormalState()
+    {
+        m_v = flushDenormal(m_v);
+    }
+
     void setCutoff(const float cutoff)
     {
         if (cutoff >= m_sampleRate / 2)
@@ -112,12 +164,23 @@ class OnePoleFilterOptimized
         {
             m_fdbk = std::exp(-2.0f * 3.14159265358979f * cutoff / m_sampleRate);
         }
+        // fdbk^1 .. fdbk^ScanLanes
+        double power = 1.0;
+        for (auto& p : m_powers)
+        {
+            power *= m_fdbk;
+            p = static_cast<float>(power);
+        }
     }
 
   private:
+    static constexpr size_t ScanLanes{8};
+
     float m_sampleRate;
     float m_fdbk{0};
+    std::array<float, ScanLanes> m_powers{};
     float m_v{0};
+    bool m_flushDenormals{false};
 };
 
 class SimpleBandpass
@@ -162,4 +225,191 @@ class SimpleBandpass
   private:
     std::array<OnePoleFilter, 2> m_lp;
 };
+
+enum class OnePoleTap
+{
+    LowPass,
+    HighPass,
+    BandPass, // a second one pole on the lowpass, the difference of both as in SimpleBandpass
+};
+
+// N independent one pole filters in simd lanes, e.g. for many envelope followers or voices
+// Each channel has its own cutoff and output tap. The poles and states are kept contiguous, one sample rate for all.
+template <size_t NumChannels>
+class OnePoleBank
+{
+  public:
+    static constexpr size_t LaneWidth = NumChannels > 4 ? 8 : 4;
+    static constexpr size_t NumGroups = (NumChannels + LaneWidth - 1) / LaneWidth;
+    static constexpr size_t PaddedChannels = NumGroups * LaneWidth;
+    using Lanes = SimdFloat<LaneWidth>;
+
+    explicit OnePoleBank(const float sampleRate)
+        : m_sampleRate(sampleRate)
+    {
+        for (size_t c = 0; c < PaddedChannels; ++c)
+        {
+            setTap(c, OnePoleTap::LowPass);
+        }
+    }
+
+    void setCutoff(const float cutoff)
+    {
+        for (size_t c = 0; c < NumChannels; ++c)
+        {
+            setCutoff(c, cutoff);
+        }
+    }
+
+    void setCutoff(const size_t channel, const float cutoff)
+    {
+        m_pole[channel] = cutoff >= m_sampleRate / 2 ? 0.f
+                                                     : std::exp(-2.0f * 3.14159265358979f * cutoff / m_sampleRate);
+    }
+
+    void setTap(const size_t channel, const OnePoleTap tap)
+    {
+        // out = input * x + first stage * s1 + second stage * s2
+        m_mixInput[channel] = tap == OnePoleTap::HighPass ? 1.f : 0.f;
+        m_mixFirst[channel] = tap == OnePoleTap::LowPass ? 1.f : -1.f;
+        m_mixSecond[channel] = tap == OnePoleTap::BandPass ? 1.f : 0.f;
+        const auto hadBandPass = m_hasBandPass;
+        m_hasBandPass = std::any_of(m_mixSecond.begin(), m_mixSecond.end(), [](const float m) { return m != 0.f; });
+        if (m_hasBandPass && !hadBandPass)
+        {
+            m_second = m_first; // the second stage was not running, it starts settled
+        }
+    }
+
+    void reset()
+    {
+        m_first.fill(0.f);
+        m_second.fill(0.f);
+    }
+
+    // one buffer per channel, in and out may be the same buffers
+    // chunks of each lane group are transposed to frames first, gathering single samples would cost more than the
+    // filtering
+    void processBlock(const float* const* in, float* const* out, const size_t numSamples)
+    {
+        dispatch(
+            [&]
+            {
+                alignas(32) std::array<float, ChunkFrames * LaneWidth> frames{};
+                for (size_t first = 0; first < NumChannels; first += LaneWidth)
+                {
+                    const auto lanes = std::min(LaneWidth, NumChannels - first);
+                    for (size_t offset = 0; offset < numSamples; offset += ChunkFrames)
+                    {
+                        const auto numFrames = std::min(ChunkFrames, numSamples - offset);
+                        for (size_t c = 0; c < lanes; ++c)
+                        {
+                            for (size_t i = 0; i < numFrames; ++i)
+                            {
+                                frames[i * LaneWidth + c] = in[first + c][offset + i];
+                            }
+                        }
+                        processGroup(
+                            first, numFrames, [&](const size_t i) { return Lanes::load(&frames[i * LaneWidth]); },
+                            [&](const size_t i, const Lanes& value) { value.store(&frames[i * LaneWidth]); });
+                        for (size_t c = 0; c < lanes; ++c)
+                        {
+                            for (size_t i = 0; i < numFrames; ++i)
+                            {
+                                out[first + c][offset + i] = frames[i * LaneWidth + c];
+                            }
+                        }
+                    }
+                }
+            });
+    }
+
+    // frames of NumChannels interleaved samples
+    void processBlockInterleaved(const float* in, float* out, const size_t numFrames)
+    {
+        dispatch(
+            [&]
+            {
+                for (size_t first = 0; first < NumChannels; first += LaneWidth)
+                {
+                    const auto lanes = std::min(LaneWidth, NumChannels - first);
+                    if (lanes == LaneWidth)
+                    {
+                        processGroup(
+                            first, numFrames, [&](const size_t i) { return Lanes::load(in + i * NumChannels + first); },
+                            [&](const size_t i, const Lanes& value) { value.store(out + i * NumChannels + first); });
+                    }
+                    else
+                    {
+                        alignas(32) std::array<float, LaneWidth> frame{};
+                        processGroup(
+                            first, numFrames,
+                            [&](const size_t i)
+                            {
+                                std::copy_n(in + i * NumChannels + first, lanes, frame.data());
+                                return Lanes::load(frame.data());
+                            },
+                            [&](const size_t i, const Lanes& value)
+                            {
+                                value.store(frame.data());
+                                std::copy_n(frame.data(), lanes, out + i * NumChannels + first);
+                            });
+                    }
+                }
+            });
+    }
+
+  private:
+    static constexpr size_t ChunkFrames{64};
+
+    template <typename ReadFrame, typename WriteFrame>
+    void processGroup(const size_t first, const size_t numSamples, ReadFrame read, WriteFrame write)
+    {
+        if (m_hasBandPass)
+        {
+            processLanes<true>(first, numSamples, read, write);
+        }
+        else
+        {
+            processLanes<false>(first, numSamples, read, write);
+        }
+    }
+
+    // the same recurrence as OnePoleFilterOptimized::next
+    template <bool SecondStage, typename ReadFrame, typename WriteFrame>
+    void processLanes(const size_t first, const size_t numSamples, ReadFrame& read, WriteFrame& write)
+    {
+        const auto pole = Lanes::load(&m_pole[first]);
+        const auto mixInput = Lanes::load(&m_mixInput[first]);
+        const auto mixFirst = Lanes::load(&m_mixFirst[first]);
+        const auto mixSecond = Lanes::load(&m_mixSecond[first]);
+        auto v1 = Lanes::load(&m_first[first]);
+        auto v2 = Lanes::load(&m_second[first]);
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto in = read(i);
+            v1 = in + pole * (v1 - in);
+            if constexpr (SecondStage)
+            {
+                v2 = v1 + pole * (v2 - v1);
+                write(i, in * mixInput + v1 * mixFirst + v2 * mixSecond);
+            }
+            else
+            {
+                write(i, in * mixInput + v1 * mixFirst);
+            }
+        }
+        v1.store(&m_first[first]);
+        v2.store(&m_second[first]);
+    }
+
+    float m_sampleRate;
+    bool m_hasBandPass{false};
+    alignas(32) std::array<float, PaddedChannels> m_pole{};
+    alignas(32) std::array<float, PaddedChannels> m_mixInput{};
+    alignas(32) std::array<float, PaddedChannels> m_mixFirst{};
+    alignas(32) std::array<float, PaddedChannels> m_mixSecond{};
+    alignas(32) std::array<float, PaddedChannels> m_first{};
+    alignas(32) std::array<float, PaddedChannels> m_second{};
+};
 }
@@ -0,0 +1,246 @@
+#pragma once
+
+#ifdef _WIN32
+#define _USE_MATH_DEFINES
+#include <math.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+namespace DSP
+{
+
+/*
+ * polyphase iir half band filters for 2x and 4x oversampling
+ *
+ * The half band filter is the sum of two chains of first order allpasses in z^-2, one for the even and one for the odd
+ * samples at the high rate. Each chain runs at the low rate, so a 2x up- or downsampler costs NumCoefficients
+ * multiplications per low rate sample. The phase is not linear, but the latency is a few samples only, which matters
+ * within a feedback path.
+ * The coefficients are the elliptic design described by Laurent de Soras for hiir.
+ */
+
+// transition is the normalized width between pass- and stopband at the high rate, 0 < transition < 0.5
+template <size_t NumCoefficients>
+std::array<float, NumCoefficients> computeHalfBandCoefficients(const double transition)
+{
+    const auto kRoot = std::tan((1.0 - transition * 2.0) * M_PI / 4.0);
+    const auto k = kRoot * kRoot;
+    const auto kksqrt = std::pow(1.0 - k * k, 0.25);
+    const auto e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+    const auto e4 = e * e * e * e;
+    const auto q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+    const auto order = static_cast<double>(NumCoefficients * 2 + 1);
+
+    std::array<float, NumCoefficients> coefficients{};
+    for (size_t index = 0; index < NumCoefficients; ++index)
+    {
+        const auto c = static_cast<double>(index + 1);
+        double numerator{0};
+        double term{1};
+        for (int i = 0, sign = 1; std::abs(term) > 1e-100; ++i, sign = -sign)
+        {
+            term = std::pow(q, i * (i + 1)) * std::sin((i * 2 + 1) * c * M_PI / order) * sign;
+            numerator += term;
+        }
+        double denominator{0.5};
+        term = 1;
+        for (int i = 1, sign = -1; std::abs(term) > 1e-100; ++i, sign = -sign)
+        {
+            term = std::pow(q, i * i) * std::cos(i * 2 * c * M_PI / order) * sign;
+            denominator += term;
+        }
+        const auto ww = numerator * std::pow(q, 0.25) / denominator;
+        const auto wwsq = ww * ww;
+        const auto x = std::sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+        coefficients[index] = static_cast<float>((1.0 - x) / (1.0 + x));
+    }
+    return coefficients;
+}
+
+// the two allpass chains, even coefficients filter the first sample, odd ones the second
+template <size_t NumCoefficients>
+class HalfBandAllPasses
+{
+  public:
+    explicit HalfBandAllPasses(const double transition)
+        : m_coefficients(computeHalfBandCoefficients<NumCoefficients>(transition))
+    {
+    }
+
+    void reset()
+    {
+        m_x.fill(0.f);
+        m_y.fill(0.f);
+    }
+
+    void process(float& first, float& second)
+    {
+        for (size_t i = 0; i + 1 < NumCoefficients; i += 2)
+        {
+            const auto firstOut = (first - m_y[i]) * m_coefficients[i] + m_x[i];
+            const auto secondOut = (second - m_y[i + 1]) * m_coefficients[i + 1] + m_x[i + 1];
+            m_x[i] = first;
+            m_x[i + 1] = second;
+            m_y[i] = firstOut;
+            m_y[i + 1] = secondOut;
+            first = firstOut;
+            second = secondOut;
+        }
+        if constexpr (NumCoefficients % 2 == 1)
+        {
+            constexpr auto last = NumCoefficients - 1;
+            const auto firstOut = (first - m_y[last]) * m_coefficients[last] + m_x[last];
+            m_x[last] = first;
+            m_y[last] = firstOut;
+            first = firstOut;
+        }
+    }
+
+  private:
+    std::array<float, NumCoefficients> m_coefficients;
+    std::array<float, NumCoefficients> m_x{};
+    std::array<float, NumCoefficients> m_y{};
+};
+
+template <size_t NumCoefficients>
+class Upsampler2x
+{
+  public:
+    explicit Upsampler2x(const double transition)
+        : m_allPasses(transition)
+    {
+    }
+
+    void reset()
+    {
+        m_allPasses.reset();
+    }
+
+    // writes 2 * numSamples
+    void processBlock(const float* in, float* out, const size_t numSamples)
+    {
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto first = in[i];
+            auto second = in[i];
+            m_allPasses.process(first, second);
+            out[i * 2] = first;
+            out[i * 2 + 1] = second;
+        }
+    }
+
+  private:
+    HalfBandAllPasses<NumCoefficients> m_allPasses;
+};
+
+template <size_t NumCoefficients>
+class Downsampler2x
+{
+  public:
+    explicit Downsampler2x(const double transition)
+        : m_allPasses(transition)
+    {
+    }
+
+    void reset()
+    {
+        m_allPasses.reset();
+    }
+
+    // reads 2 * numSamples
+    void processBlock(const float* in, float* out, const size_t numSamples)
+    {
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto first = in[i * 2 + 1];
+            auto second = in[i * 2];
+            m_allPasses.process(first, second);
+            out[i] = 0.5f * (first + second);
+        }
+    }
+
+  private:
+    HalfBandAllPasses<NumCoefficients> m_allPasses;
+};
+
+/*
+ * up- and downsampling by Factor 1, 2 or 4 around a process running at the high rate
+ * The first 2x stage keeps the audio band up to 0.45 of the low rate, the second one of 4x only has to reject
+ * the images above that, so it gets by with fewer coefficients.
+ */
+template <size_t Factor>
+class Oversampler
+{
+    static_assert(Factor == 1 || Factor == 2 || Factor == 4, "oversampling by 1, 2 or 4");
+
+  public:
+    static constexpr size_t MaxBlockSize{64};
+    // about 80 dB and 90 dB image and alias rejection
+    static constexpr size_t FirstStageCoefficients{6};
+    static constexpr size_t SecondStageCoefficients{3};
+    static constexpr double FirstStageTransition{0.05};
+    static constexpr double SecondStageTransition{0.25};
+
+    Oversampler()
+        : m_up{Upsampler2x<FirstStageCoefficients>(FirstStageTransition),
+               Upsampler2x<SecondStageCoefficients>(SecondStageTransition)}
+        , m_down{Downsampler2x<FirstStageCoefficients>(FirstStageTransition),
+                 Downsampler2x<SecondStageCoefficients>(SecondStageTransition)}
+    {
+    }
+
+    void reset()
+    {
+        std::get<0>(m_up).reset();
+        std::get<1>(m_up).reset();
+        std::get<0>(m_down).reset();
+        std::get<1>(m_down).reset();
+    }
+
+    // writes Factor * numSamples, numSamples <= MaxBlockSize
+    void upsample(const float* in, float* out, const size_t numSamples)
+    {
+        if constexpr (Factor == 1)
+        {
+            std::copy(in, in + numSamples, out);
+        }
+        else if constexpr (Factor == 2)
+        {
+            std::get<0>(m_up).processBlock(in, out, numSamples);
+        }
+        else
+        {
+            std::get<0>(m_up).processBlock(in, m_between.data(), numSamples);
+            std::get<1>(m_up).processBlock(m_between.data(), out, numSamples * 2);
+        }
+    }
+
+    // reads Factor * numSamples, numSamples <= MaxBlockSize
+    void downsample(const float* in, float* out, const size_t numSamples)
+    {
+        if constexpr (Factor == 1)
+        {
+            std::copy(in, in + numSamples, out);
+        }
+        else if constexpr (Factor == 2)
+        {
+            std::get<0>(m_down).processBlock(in, out, numSamples);
+        }
+        else
+        {
+            std::get<1>(m_down).processBlock(in, m_between.data(), numSamples * 2);
+            std::get<0>(m_down).processBlock(m_between.data(), out, numSamples);
+        }
+    }
+
+  private:
+    std::pair<Upsampler2x<FirstStageCoefficients>, Upsampler2x<SecondStageCoefficients>> m_up;
+    std::pair<Downsampler2x<FirstStageCoefficients>, Downsampler2x<SecondStageCoefficients>> m_down;
+    std::array<float, MaxBlockSize * 2> m_between{};
+};
+}
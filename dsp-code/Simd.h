@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+/*
+ * a thin wrapper around a register of float lanes
+ *
+ * With gcc and clang the compiler vector extensions are used, so the very same code is lowered to
+ * SSE, AVX2, AVX-512 or NEON registers depending on the target flags (a 8 lane vector on plain SSE becomes
+ * two xmm registers). Other compilers get the scalar fallback, a plain array the optimizer may still vectorize.
+ */
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi" // 32 byte vectors passed by value without -mavx
+#endif
+
+namespace DSP
+{
+
+#if defined(__AVX512F__)
+inline constexpr size_t SimdNativeLanes = 16;
+#elif defined(__AVX__)
+inline constexpr size_t SimdNativeLanes = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON)
+inline constexpr size_t SimdNativeLanes = 4;
+#else
+inline constexpr size_t SimdNativeLanes = 1;
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DSP_SIMD_VECTOR_EXTENSIONS 1
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_shufflevector) // gcc 12 and clang
+#define DSP_SIMD_SHUFFLE 1
+#endif
+#endif
+#endif
+
+template <size_t Lanes>
+struct SimdRegister
+{
+    using Type = std::array<float, Lanes>;
+};
+
+#ifdef DSP_SIMD_VECTOR_EXTENSIONS
+// spelled out, a vector_size depending on a template parameter is not reliably supported
+template <>
+struct SimdRegister<4>
+{
+    typedef float Type __attribute__((vector_size(16)));
+};
+
+template <>
+struct SimdRegister<8>
+{
+    typedef float Type __attribute__((vector_size(32)));
+};
+
+template <>
+struct SimdRegister<16>
+{
+    typedef float Type __attribute__((vector_size(64)));
+};
+#endif
+
+template <size_t Lanes>
+class SimdFloat
+{
+    static_assert(Lanes == 4 || Lanes == 8 || Lanes == 16, "only 4, 8 or 16 lanes are supported");
+
+  public:
+    using Register = typename SimdRegister<Lanes>::Type;
+    static constexpr size_t size()
+    {
+        return Lanes;
+    }
+
+    SimdFloat() = default;
+
+    explicit SimdFloat(const Register& r)
+        : v(r)
+    {
+    }
+
+    static SimdFloat broadcast(const float value)
+    {
+        SimdFloat result;
+#ifdef DSP_SIMD_VECTOR_EXTENSIONS
+        result.v = value - Register{}; // splats the scalar into all lanes
+#else
+        result.v.fill(value);
+#endif
+        return result;
+    }
+
+    static SimdFloat zero()
+    {
+        return SimdFloat{Register{}};
+    }
+
+    // unaligned load and store, the compiler emits movups/vld1q
+    static SimdFloat load(const float* source)
+    {
+        SimdFloat result;
+        std::memcpy(&result.v, source, sizeof(Register));
+        return result;
+    }
+
+    void store(float* target) const
+    {
+        std::memcpy(target, &v, sizeof(Register));
+    }
+
+    [[nodiscard]] float operator[](const size_t lane) const
+    {
+        return v[lane];
+    }
+
+    void set(const size_t lane, const float value)
+    {
+        v[lane] = value;
+    }
+
+    friend SimdFloat operator+(const SimdFloat& lhs, const SimdFloat& rhs)
+    {
+#ifdef DSP_SIMD_VECTOR_EXTENSIONS
+        return SimdFloat{lhs.v + rhs.v};
+#else
+        return apply(lhs, rhs, [](float a, float b) { return a + b; });
+#endif
+    }
+
+    friend SimdFloat operator-(const SimdFloat& lhs, const SimdFloat& rhs)
+    {
+#ifdef DSP_SIMD_VECTOR_EXTENSIONS
+        return SimdFloat{lhs.v - rhs.v};
+#else
+        return apply(lhs, rhs, [](float a, float b) { return a - b; });
+#endif
+    }
+
+    friend SimdFloat operator*(const SimdFloat& lhs, const SimdFloat& rhs)
+    {
+#ifdef DSP_SIMD_VECTOR_EXTENSIONS
+        return SimdFloat{lhs.v * rhs.v};
+#else
+        return apply(lhs, rhs, [](float a, float b) { return a * b; });
+#endif
+    }
+
+    friend SimdFloat operator/(const SimdFloat& lhs, const SimdFloat& rhs)
+    {
+#ifdef DSP_SIMD_VECTOR_EXTENSIONS
+        return SimdFloat{lhs.v / rhs.v};
+#else
+        return apply(lhs, rhs, [](float a, float b) { return a / b; });
+#endif
+    }
+
+    friend SimdFloat operator-(const SimdFloat& value)
+    {
+        return zero() - value;
+    }
+
+    SimdFloat& operator+=(const SimdFloat& rhs)
+    {
+        return *this = *this + rhs;
+    }
+
+    SimdFloat& operator-=(const SimdFloat& rhs)
+    {
+        return *this = *this - rhs;
+    }
+
+    SimdFloat& operator*=(const SimdFloat& rhs)
+    {
+        return *this = *this * rhs;
+    }
+
+    // lane i takes the value of lane i - 1, lane 0 takes first
+    [[nodiscard]] SimdFloat shiftUp(const float first) const
+    {
+        SimdFloat result;
+#ifdef DSP_SIMD_SHUFFLE
+        shuffleUp(result.v, std::make_index_sequence<Lanes>{});
+#else
+        for (size_t i = Lanes - 1; i > 0; --i)
+        {
+            result.v[i] = v[i - 1];
+        }
+#endif
+        result.v[0] = first;
+        return result;
+    }
+
+    // lane i takes the value of lane i - Count, the lower Count lanes become 0
+    template <size_t Count>
+    [[nodiscard]] SimdFloat shiftUp() const
+    {
+        static_assert(Count < Lanes);
+        SimdFloat result;
+#ifdef DSP_SIMD_SHUFFLE
+        shuffleUpBy<Count>(result.v, std::make_index_sequence<Lanes>{});
+#else
+        for (size_t i = 0; i < Lanes; ++i)
+        {
+            result.v[i] = i < Count ? 0.f : v[i - Count];
+        }
+#endif
+        return result;
+    }
+
+    // lane i takes the value of lane i ^ Mask, e.g. Mask 1 swaps neighbours
+    template <size_t Mask>
+    [[nodiscard]] SimdFloat swapLanes() const
+    {
+        static_assert(Mask < Lanes);
+        SimdFloat result;
+#ifdef DSP_SIMD_SHUFFLE
+        swapLanesBy<Mask>(result.v, std::make_index_sequence<Lanes>{});
+#else
+        for (size_t i = 0; i < Lanes; ++i)
+        {
+            result.v[i] = v[i ^ Mask];
+        }
+#endif
+        return result;
+    }
+
+    [[nodiscard]] float sum() const
+    {
+        float result{0.f};
+        for (size_t i = 0; i < Lanes; ++i)
+        {
+            result += v[i];
+        }
+        return result;
+    }
+
+    Register v;
+
+  private:
+#ifdef DSP_SIMD_SHUFFLE
+    // the helpers have no return value, an avx register returned without -mavx triggers a psabi warning
+    template <size_t... Index>
+    void shuffleUp(Register& result, std::index_sequence<Index...>) const
+    {
+        result = __builtin_shufflevector(v, v, (Index == 0 ? 0 : Index - 1)...);
+    }
+
+    // an index of Lanes and above picks from the second vector, the zeros
+    template <size_t Count, size_t... Index>
+    void shuffleUpBy(Register& result, std::index_sequence<Index...>) const
+    {
+        result = __builtin_shufflevector(v, Register{}, (Index < Count ? Lanes : Index - Count)...);
+    }
+
+    template <size_t Mask, size_t... Index>
+    void swapLanesBy(Register& result, std::index_sequence<Index...>) const
+    {
+        result = __builtin_shufflevector(v, v, (Index ^ Mask)...);
+    }
+#endif
+
+#ifndef DSP_SIMD_VECTOR_EXTENSIONS
+    template <typename Operation>
+    static SimdFloat apply(const SimdFloat& lhs, const SimdFloat& rhs, Operation op)
+    {
+        SimdFloat result;
+        for (size_t i = 0; i < Lanes; ++i)
+        {
+            result.v[i] = op(lhs.v[i], rhs.v[i]);
+        }
+        return result;
+    }
+#endif
+};
+
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
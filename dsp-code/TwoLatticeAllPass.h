@@ -1,18 +1,145 @@
 #pragma once
+#include "Denormals.h"
 #include "OnePoleFilter.h"
 
+#include <algorithm>
+#include <array>
 #include <vector>
 
 namespace DSP
 {
 
+inline constexpr size_t MaxLatticeSegmentSize{64};
+
+// numSamples <= MaxLatticeSegmentSize of an allpass, read from delayed and the lowpassed feed written to written,
+// both without wrapping and numSamples not longer than the delay, source and target may be the same
+inline void latticeAllPassSegment(const float* source, float* target, const float* delayed, float* written,
+                                  const float feedback, OnePoleFilter& lowpass, const size_t numSamples)
+{
+    std::array<float, MaxLatticeSegmentSize> feedDelay;
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        const auto delayedValue = delayed[i];
+        feedDelay[i] = source[i] - delayedValue * feedback; // N.B. negative feedback
+        target[i] = feedDelay[i] * feedback + delayedValue;
+    }
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        written[i] = lowpass.next(feedDelay[i]);
+    }
+}
+
+/*
+ * an allpass (one lattice of a schroeder allpass) with a one pole lowpass in the delay
+ *
+ * A block is split into segments that neither wrap around the buffer nor read what the segment writes (no longer
+ * than the delay), so there is no modulo per sample. Within a segment the reads and the allpass run in a loop that
+ * is vectorized, the lowpass is a recurrence and runs on its own. The results are the same as of one step after the
+ * other.
+ */
 template <size_t MaxDelayLength>
 class TwoLatticeAllPass
 {
   public:
+    static constexpr size_t MinSize{51};
+    static constexpr size_t MaxSegmentSize{MaxLatticeSegmentSize};
+
     TwoLatticeAllPass(float sampleRate)
         : m_lowpass(sampleRate)
         , m_buffer(MaxDelayLength, 0.f)
+    {
+    }
+
+    void clear()
+    {
+        std::fill(m_buffer.begin(), m_buffer.end(), 0.f);
+    }
+
+    void setLowpassCutoff(const float value)
+    {
+        m_lowpass.setCutoff(value);
+    }
+
+    void setFeedback(const float gain)
+    {
+        m_feedback = std::clamp(gain, -0.999999f, 0.999999f);
+    }
+
+    void setSize(const size_t newSize)
+    {
+        m_size = std::clamp<size_t>(newSize, MinSize, MaxDelayLength);
+        m_headRead = MaxDelayLength + m_headWrite - m_size;
+        if (m_headRead >= MaxDelayLength)
+        {
+            m_headRead -= MaxDelayLength;
+        }
+    }
+
+    void processBlock(const float* source, float* target, size_t numSamples)
+    {
+        for (size_t index = 0; index < numSamples;)
+        {
+            const auto segment = std::min({numSamples - index, MaxSegmentSize, m_size, MaxDelayLength - m_headRead,
+                                           MaxDelayLength - m_headWrite});
+            processSegment(source + index, target + index, segment);
+            index += segment;
+        }
+        if (m_flushDenormals)
+        {
+            flushDenormalState(numSamples);
+        }
+    }
+
+    void processBlockInplace(float* inplace, size_t numSamples)
+    {
+        processBlock(inplace, inplace, numSamples);
+    }
+
+    // flushes the samples written to the delay line in the block and the lowpass state
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
+    }
+
+  private:
+    void flushDenormalState(const size_t numWritten)
+    {
+        m_lowpass.flushDenormalState();
+        const auto count = std::min(numWritten, MaxDelayLength);
+        const auto start = (m_headWrite + MaxDelayLength - count) % MaxDelayLength;
+        const auto firstPart = std::min(count, MaxDelayLength - start);
+        flushDenormals(m_buffer.data() + start, firstPart);
+        flushDenormals(m_buffer.data(), count - firstPart);
+    }
+
+    // source and target may be the same
+    void processSegment(const float* source, float* target, const size_t numSamples)
+    {
+        latticeAllPassSegment(source, target, m_buffer.data() + m_headRead, m_buffer.data() + m_headWrite,
+                              m_feedback, m_lowpass, numSamples);
+        m_headRead += numSamples;
+        m_headRead = m_headRead == MaxDelayLength ? 0 : m_headRead;
+        m_headWrite += numSamples;
+        m_headWrite = m_headWrite == MaxDelayLength ? 0 : m_headWrite;
+    }
+
+    OnePoleFilter m_lowpass;
+    float m_feedback{0.0f};
+    size_t m_size{MaxDelayLength};
+    size_t m_headRead{0};
+    size_t m_headWrite{0};
+    std::vector<float> m_buffer{};
+    bool m_flushDenormals{false};
+};
+
+// the former implementation, one step per sample with two modulo operations, for comparison
+template <size_t MaxDelayLength>
+class TwoLatticeAllPassPerSample
+{
+  public:
+    TwoLatticeAllPassPerSample(float sampleRate)
+        : m_lowpass(sampleRate)
+        , m_buffer(MaxDelayLength, 0.f)
     {
         m_buffer.resize(MaxDelayLength);
         clear();
@@ -46,14 +173,38 @@ class TwoLatticeAllPass
     void processBlock(const float* source, float* target, size_t numSamples)
     {
         std::transform(source, source + numSamples, target, [this](float in) { return step(in); });
+        if (m_flushDenormals)
+        {
+            flushDenormalState(numSamples);
+        }
     }
 
     void processBlockInplace(float* inplace, size_t numSamples)
     {
         std::transform(inplace, inplace + numSamples, inplace, [this](float in) { return step(in); });
+        if (m_flushDenormals)
+        {
+            flushDenormalState(numSamples);
+        }
+    }
+
+    // see TwoLatticeAllPass::setFlushDenormals
+    void setFlushDenormals(const bool enabled)
+    {
+        m_flushDenormals = enabled;
     }
 
   private:
+    void flushDenormalState(const size_t numWritten)
+    {
+        m_lowpass.flushDenormalState();
+        const auto count = std::min(numWritten, MaxDelayLength);
+        const auto start = (m_headWrite + MaxDelayLength - count) % MaxDelayLength;
+        const auto firstPart = std::min(count, MaxDelayLength - start);
+        flushDenormals(m_buffer.data() + start, firstPart);
+        flushDenormals(m_buffer.data(), count - firstPart);
+    }
+
     float step(const float in)
     {
         const auto delayedValue = nextHeadRead();
@@ -76,5 +227,6 @@ class TwoLatticeAllPass
     size_t m_headRead{0};
     size_t m_headWrite{0};
     std::vector<float> m_buffer{};
+    bool m_flushDenormals{false};
 };
 }
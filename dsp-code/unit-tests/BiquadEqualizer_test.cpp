@@ -9,6 +9,7 @@
 #include <array>
 #include <cmath>
 #include <numbers>
+#include <tuple>
 
 namespace DspTest
 {
@@ -199,4 +200,193 @@ TEST(DspEqualizerTests, swappingEq)
         EXPECT_LT(db, expectedDb) << "right channel failure @" << hz;
     }
 }
+
+TEST(DspEqualizerTests, magnitudeResponseMatchesSinglePoints)
+{
+    constexpr size_t Order{4};
+    DSP::BiquadEqualizer<Order> sut(48000.f);
+    sut.setBass(3, 100, 0.907);
+    sut.setParametric(1000, 0.407, -4.f);
+    sut.setTreble(Order, 6000, 3.707);
+
+    std::vector<float> frequencies;
+    for (float hz = 20.f; hz < 22000.f; hz *= 1.05f)
+    {
+        frequencies.push_back(hz);
+    }
+    std::vector<float> db(frequencies.size(), 0);
+    sut.magnitudeResponse(frequencies, db);
+    for (size_t i = 0; i < frequencies.size(); ++i)
+    {
+        EXPECT_NEAR(db[i], sut.getMagnitude(frequencies[i]), 0.01f) << "@" << frequencies[i];
+    }
+
+    // a new setting invalidates the cached response
+    sut.setParametric(1000, 0.407, 6.f);
+    sut.magnitudeResponse(frequencies, db);
+    for (size_t i = 0; i < frequencies.size(); ++i)
+    {
+        EXPECT_NEAR(db[i], sut.getMagnitude(frequencies[i]), 0.01f) << "@" << frequencies[i];
+    }
+}
+
+TEST(DspEqualizerTests, smoothChunksAnyBlockSize)
+{
+    constexpr size_t Order{3};
+    DSP::BiquadEqualizerSmooth<Order> oneBlock(48000.f);
+    DSP::BiquadEqualizerSmooth<Order> manyBlocks(48000.f);
+    std::vector<float> wave(10000, 0);
+    renderWithSineWave(wave, 48000.0, 150.0);
+    std::vector<float> expectedLeft(wave.size(), 0);
+    std::vector<float> expectedRight(wave.size(), 0);
+    std::vector<float> left(wave.size(), 0);
+    std::vector<float> right(wave.size(), 0);
+    for (auto* sut : {&oneBlock, &manyBlocks})
+    {
+        sut->setBassOrder(Order);
+        sut->setBassCutoff(200.f); // pending until the fade of the order ends
+        sut->setParametricGain(6.f);
+    }
+
+    oneBlock.processBlock(wave.data(), wave.data(), expectedLeft.data(), expectedRight.data(), wave.size());
+    size_t blockSize = 1;
+    for (size_t offset = 0; offset < wave.size(); offset += blockSize, blockSize = blockSize * 3 + 1)
+    {
+        const auto numSamples = std::min(blockSize, wave.size() - offset);
+        manyBlocks.processBlock(wave.data() + offset, wave.data() + offset, left.data() + offset,
+                                right.data() + offset, numSamples);
+    }
+    for (size_t i = 0; i < wave.size(); ++i)
+    {
+        ASSERT_EQ(left[i], expectedLeft[i]) << "sample " << i;
+        ASSERT_EQ(right[i], expectedRight[i]) << "sample " << i;
+    }
+}
+
+TEST(DspEqualizerTests, smoothIsPassThroughUntilTheFirstSetter)
+{
+    constexpr size_t Order{2};
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadEqualizerSmooth<Order> sut(sampleRate);
+    std::vector<float> wave(10000, 0);
+    renderWithSineWave(wave, sampleRate, 50.0);
+    std::vector<float> left(wave.size(), 0);
+    std::vector<float> right(wave.size(), 0);
+
+    sut.processBlock(wave.data(), wave.data(), left.data(), right.data(), wave.size());
+    EXPECT_FALSE(sut.isFading());
+    EXPECT_EQ(sut.getMagnitude(50.f), 0.f);
+    for (size_t i = 0; i < wave.size(); ++i)
+    {
+        ASSERT_EQ(left[i], wave[i]) << "sample " << i;
+        ASSERT_EQ(right[i], wave[i]) << "sample " << i;
+    }
+
+    // any setter fades in all sections, the bass cut of 100 Hz as well
+    sut.setParametricGain(3.f);
+    EXPECT_TRUE(sut.isFading());
+    sut.processBlock(wave.data(), wave.data(), left.data(), right.data(), wave.size());
+    EXPECT_FALSE(sut.isFading());
+    EXPECT_LT(sut.getMagnitude(50.f), -3.f);
+}
+
+// stages left out after a loud passage start from silence when they come back, not with the old state
+TEST(DspEqualizerTests, smoothReenablesStagesWithoutTransient)
+{
+    constexpr size_t Order{4};
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadEqualizerSmooth<Order> sut(sampleRate);
+    std::vector<float> wave(48000, 0);
+    renderWithSineWave(wave, sampleRate, 300.0);
+    std::vector<float> silence(wave.size(), 0);
+    std::vector<float> left(wave.size(), 0);
+    std::vector<float> right(wave.size(), 0);
+
+    sut.setBassOrder(Order);
+    sut.setParametricGain(12.f);
+    sut.processBlock(wave.data(), wave.data(), left.data(), right.data(), wave.size());
+    sut.setBassOrder(1);
+    sut.setParametricGain(0.f);
+    sut.processBlock(silence.data(), silence.data(), left.data(), right.data(), silence.size());
+    ASSERT_FALSE(sut.isFading());
+
+    sut.setBassOrder(Order);
+    sut.setParametricGain(12.f);
+    sut.processBlock(silence.data(), silence.data(), left.data(), right.data(), silence.size());
+    for (size_t i = 0; i < silence.size(); ++i)
+    {
+        ASSERT_LT(std::abs(left[i]), 1E-6f) << "sample " << i;
+        ASSERT_LT(std::abs(right[i]), 1E-6f) << "sample " << i;
+    }
+}
+
+TEST(DspEqualizerTests, smoothFadesEachChannelAndEndsAtTheStaticEq)
+{
+    constexpr size_t Order{2};
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadEqualizerSmooth<Order> sut(sampleRate);
+    DSP::BiquadEqualizer<Order> reference(sampleRate);
+    std::vector<float> wave(48000, 0);
+    renderWithSineWave(wave, sampleRate, 300.0);
+    std::vector<float> silence(wave.size(), 0);
+    std::vector<float> left(wave.size(), 0);
+    std::vector<float> right(wave.size(), 0);
+    std::vector<float> expectedLeft(wave.size(), 0);
+    std::vector<float> expectedRight(wave.size(), 0);
+
+    sut.setParametricCutoff(400.f);
+    sut.setParametricGain(-9.f);
+    sut.setTrebleOrder(Order);
+    sut.setTrebleCutoff(2000.f);
+    EXPECT_TRUE(sut.isFading());
+    reference.setBass(1, 100.f, 0.707f);
+    reference.setParametric(400.f, 0.707f, -9.f);
+    reference.setTreble(Order, 2000.f, 0.707f);
+
+    // only the left channel has a signal, the right one must stay silent during the fade
+    sut.processBlock(wave.data(), silence.data(), left.data(), right.data(), wave.size());
+    reference.processBlock(wave.data(), silence.data(), expectedLeft.data(), expectedRight.data(), wave.size());
+    EXPECT_FALSE(sut.isFading());
+    EXPECT_TRUE(std::all_of(right.begin(), right.end(), [](const float v) { return v == 0.f; }));
+    for (size_t i = wave.size() / 2; i < wave.size(); ++i)
+    {
+        ASSERT_NEAR(left[i], expectedLeft[i], 1E-4f) << "sample " << i;
+    }
+    EXPECT_NEAR(sut.getMagnitude(300.f), reference.getMagnitude(300.f), 1E-4f);
+}
+
+TEST(DspEqualizerTests, fusedMatchesSerial)
+{
+    constexpr size_t MaxOrder{4};
+    DSP::BiquadEqualizer<MaxOrder> sut(48000.f);
+    DSP::BiquadEqualizer<MaxOrder> reference(48000.f);
+    std::vector<float> left(480, 0);
+    std::vector<float> right(left.size(), 0);
+    renderWithSineWave(left, 48000.0, 90.0);
+    renderWithSineWave(right, 48000.0, 7000.0);
+    std::vector<float> outLeft(left.size(), 0);
+    std::vector<float> outRight(left.size(), 0);
+    std::vector<float> expectedLeft(left.size(), 0);
+    std::vector<float> expectedRight(left.size(), 0);
+
+    // the settings change between the blocks, the states carry over to the other kernels
+    for (const auto& [lowOrder, gain, trebleOrder] : {std::tuple{1, 0.f, 1}, std::tuple{3, -6.f, 4},
+                                                     std::tuple{4, 3.f, 2}, std::tuple{2, 0.f, 3}})
+    {
+        for (auto* eq : {&sut, &reference})
+        {
+            eq->setBass(lowOrder, 120.f, 0.8f);
+            eq->setParametric(900.f, 1.2f, gain);
+            eq->setTreble(trebleOrder, 5000.f, 0.6f);
+        }
+        sut.processBlock(left.data(), right.data(), outLeft.data(), outRight.data(), left.size());
+        reference.processBlockSerial(left.data(), right.data(), expectedLeft.data(), expectedRight.data(),
+                                     left.size());
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            ASSERT_NEAR(outLeft[i], expectedLeft[i], 1E-6f) << "low order " << lowOrder << " sample " << i;
+            ASSERT_NEAR(outRight[i], expectedRight[i], 1E-6f) << "low order " << lowOrder << " sample " << i;
+        }
+    }
+}
 }
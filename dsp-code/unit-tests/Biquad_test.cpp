@@ -875,6 +875,439 @@ TEST(DspBiquadFilterTest, checkCoefficientsType2HighPass)
     }
 }
 
+TEST(DspBiquadFilterTest, chebyshevStateSpaceMatchesSerial)
+{
+    constexpr auto sampleRate{48000.0f};
+    constexpr size_t numSamples{4801}; // not a multiple of the block width
+    std::vector<float> wave(numSamples, 0);
+    renderWithSineWave(wave, sampleRate, 997.f);
+    wave[0] = 1.f;
+    for (const auto processing :
+         {DSP::ChebyshevBiquad::Processing::StateSpace4, DSP::ChebyshevBiquad::Processing::StateSpace8})
+    {
+        for (size_t order = 1; order <= DSP::ChebyshevBiquad::MAX_ORDER; ++order)
+        {
+            for (const auto isType1 : {true, false})
+            {
+                for (const auto isLowPass : {true, false})
+                {
+                    DSP::ChebyshevBiquad serial;
+                    DSP::ChebyshevBiquad sut;
+                    for (auto* filter : {&serial, &sut})
+                    {
+                        filter->setSampleRate(sampleRate);
+                        isType1 ? filter->computeType1(order, 1000, 3, isLowPass)
+                                : filter->computeType2(order, 1000, 3, isLowPass);
+                    }
+                    sut.setProcessing(processing);
+                    // the serial float path is off by a similar amount, the poles move close to the unit circle
+                    const auto tolerance = 5E-5f * static_cast<float>(order * order);
+                    std::vector<float> expected(numSamples, 0);
+                    std::vector<float> expectedRight(numSamples, 0);
+                    std::vector<float> left(numSamples, 0);
+                    std::vector<float> right(numSamples, 0);
+                    // two calls, the second one continues from the state of the first
+                    serial.processBlock(wave.data(), expected.data(), 1000);
+                    serial.processBlock(wave.data() + 1000, expected.data() + 1000, numSamples - 1000);
+                    sut.processBlock(wave.data(), left.data(), 1000);
+                    sut.processBlock(wave.data() + 1000, left.data() + 1000, numSamples - 1000);
+                    for (size_t i = 0; i < numSamples; ++i)
+                    {
+                        ASSERT_NEAR(left[i], expected[i], tolerance) << "order " << order << " sample " << i;
+                    }
+                    serial.processBlockStereo(wave.data(), wave.data(), expected.data(), expectedRight.data(),
+                                              numSamples);
+                    sut.processBlockStereo(wave.data(), wave.data(), left.data(), right.data(), numSamples);
+                    for (size_t i = 0; i < numSamples; ++i)
+                    {
+                        ASSERT_NEAR(left[i], expected[i], tolerance) << "order " << order << " sample " << i;
+                        ASSERT_NEAR(right[i], expectedRight[i], tolerance) << "order " << order << " sample " << i;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(DspBiquadFilterTest, chebyshevPipelinedMatchesDelayedSerial)
+{
+    constexpr auto sampleRate{48000.0f};
+    constexpr size_t numSamples{4800};
+    std::vector<float> wave(numSamples, 0);
+    renderWithSineWave(wave, sampleRate, 997.f);
+    wave[0] = 1.f;
+    for (size_t order = 1; order <= DSP::ChebyshevBiquad::MAX_ORDER; ++order)
+    {
+        for (const auto isType1 : {true, false})
+        {
+            DSP::ChebyshevBiquad serial;
+            DSP::ChebyshevBiquad sut;
+            for (auto* filter : {&serial, &sut})
+            {
+                filter->setSampleRate(sampleRate);
+                isType1 ? filter->computeType1(order, 1000, 3, true) : filter->computeType2(order, 1000, 3, true);
+            }
+            sut.setProcessing(DSP::ChebyshevBiquad::Processing::Pipelined);
+            const auto latency = sut.latencyInSamples();
+            EXPECT_EQ(latency, (order + 1) / 2 - 1);
+            EXPECT_EQ(serial.latencyInSamples(), 0u);
+
+            const auto tolerance = 5E-5f * static_cast<float>(order * order);
+            std::vector<float> expected(numSamples, 0);
+            std::vector<float> left(numSamples, 0);
+            std::vector<float> right(numSamples, 0);
+            serial.processBlock(wave.data(), expected.data(), numSamples);
+            sut.processBlock(wave.data(), left.data(), 1000);
+            sut.processBlock(wave.data() + 1000, left.data() + 1000, numSamples - 1000);
+            for (size_t i = 0; i + latency < numSamples; ++i)
+            {
+                ASSERT_NEAR(left[i + latency], expected[i], tolerance) << "order " << order << " sample " << i;
+            }
+
+            DSP::ChebyshevBiquad stereo;
+            stereo.setSampleRate(sampleRate);
+            isType1 ? stereo.computeType1(order, 1000, 3, true) : stereo.computeType2(order, 1000, 3, true);
+            stereo.setProcessing(DSP::ChebyshevBiquad::Processing::Pipelined);
+            stereo.processBlockStereo(wave.data(), wave.data(), left.data(), right.data(), numSamples);
+            for (size_t i = 0; i + latency < numSamples; ++i)
+            {
+                ASSERT_NEAR(left[i + latency], expected[i], tolerance) << "order " << order << " sample " << i;
+                ASSERT_NEAR(right[i + latency], expected[i], tolerance) << "order " << order << " sample " << i;
+            }
+        }
+    }
+}
+
+TEST(DspBiquadBankTest, matchesSingleChannelFilters)
+{
+    constexpr size_t NumChannels{11}; // one full group of 8 lanes and a partial one
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadBank<DSP::BiquadFilterType::Peak, NumChannels> sut;
+    std::array<DSP::BiquadOriginal, NumChannels> reference;
+    std::array<std::vector<float>, NumChannels> wave;
+    std::array<std::vector<float>, NumChannels> expected;
+    std::array<const float*, NumChannels> in{};
+    std::array<float*, NumChannels> out{};
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        const auto hz = 100.f * static_cast<float>(c + 1);
+        sut.computeCoefficients(c, sampleRate, hz, 0.707f, 6.f - static_cast<float>(c));
+        reference[c].computeCoefficients(DSP::BiquadFilterType::Peak, sampleRate, hz, 0.707f,
+                                         6.f - static_cast<float>(c));
+        wave[c].resize(1024);
+        renderWithSineWave(wave[c], sampleRate, 50.f * static_cast<float>(c + 1));
+        expected[c].resize(wave[c].size());
+        reference[c].processBlock(wave[c].data(), expected[c].data(), wave[c].size());
+        in[c] = wave[c].data();
+        out[c] = wave[c].data(); // in place
+    }
+    sut.processBlock(in.data(), out.data(), 1000);
+    std::transform(in.begin(), in.end(), in.begin(), [](const float* p) { return p + 1000; });
+    std::transform(out.begin(), out.end(), out.begin(), [](float* p) { return p + 1000; });
+    sut.processBlock(in.data(), out.data(), 24);
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        for (size_t i = 0; i < wave[c].size(); ++i)
+        {
+            // the avx2/avx-512 variants contract to fma, the rounding error of the 100 Hz filters accumulates
+            EXPECT_NEAR(wave[c][i], expected[c][i], 2E-4f) << "channel " << c << " sample " << i;
+        }
+    }
+}
+
+TEST(DspBiquadBankTest, interleavedMatchesPlanar)
+{
+    constexpr size_t NumChannels{6};
+    constexpr size_t NumFrames{512};
+    DSP::BiquadBank<DSP::BiquadFilterType::LowPass, NumChannels> planar;
+    DSP::BiquadBank<DSP::BiquadFilterType::LowPass, NumChannels> interleaved;
+    planar.computeCoefficients(48000.f, 2000.f, 0.707f, 0.f);
+    interleaved.computeCoefficients(48000.f, 2000.f, 0.707f, 0.f);
+    planar.computeCoefficients(5, 48000.f, 200.f, 2.f, 0.f);
+    interleaved.computeCoefficients(5, 48000.f, 200.f, 2.f, 0.f);
+
+    std::array<std::vector<float>, NumChannels> channels;
+    std::array<float*, NumChannels> pointers{};
+    std::vector<float> frames(NumFrames * NumChannels);
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        channels[c].resize(NumFrames);
+        renderWithSineWave(channels[c], 48000.f, 1000.f * static_cast<float>(c + 1));
+        for (size_t i = 0; i < NumFrames; ++i)
+        {
+            frames[i * NumChannels + c] = channels[c][i];
+        }
+        pointers[c] = channels[c].data();
+    }
+    planar.processBlock(pointers.data(), pointers.data(), NumFrames);
+    interleaved.processBlockInterleaved(frames.data(), frames.data(), NumFrames);
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        for (size_t i = 0; i < NumFrames; ++i)
+        {
+            EXPECT_FLOAT_EQ(frames[i * NumChannels + c], channels[c][i]);
+        }
+    }
+}
+
+TEST(DspBiquadBankTest, stereoDropInForBiquadStereo)
+{
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadBank<DSP::BiquadFilterType::HighPass, 2> sut;
+    sut.computeCoefficients(sampleRate, 500.f, 0.707f, 0.f);
+    std::vector<float> wave(48000, 0);
+    std::vector<float> left(48000, 0);
+    std::vector<float> right(48000, 0);
+    for (float hz = 50.f; hz < 20000.f; hz *= 2.f)
+    {
+        renderWithSineWave(wave, sampleRate, hz);
+        sut.processBlock(wave.data(), wave.data(), left.data(), right.data(), wave.size());
+        const auto [minV, maxV] = std::minmax_element(left.begin() + left.size() / 2, left.end());
+        const auto db = std::log10(std::max(std::abs(*minV), std::abs(*maxV))) * 20.0f;
+        EXPECT_NEAR(db, sut.magnitudeInDb(0, hz / sampleRate), maxDeltaDb) << "failure @" << hz;
+        EXPECT_EQ(left, right);
+    }
+}
+
+TEST(DspBiquadFilterTest, smoothWithoutRampMatchesStereo)
+{
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadStereo<DSP::BiquadFilterType::Peak> reference;
+    DSP::BiquadStereoSmooth<DSP::BiquadFilterType::Peak> sut;
+    reference.computeCoefficients(sampleRate, 1000.f, 0.707f, 6.f);
+    sut.setSmoothingSteps(0);
+    sut.computeCoefficients(sampleRate, 1000.f, 0.707f, 6.f);
+
+    std::vector<float> wave(4800, 0);
+    renderWithSineWave(wave, sampleRate, 997.f);
+    std::vector<float> expected(wave.size(), 0);
+    std::vector<float> left(wave.size(), 0);
+    std::vector<float> right(wave.size(), 0);
+    reference.processBlock(wave.data(), wave.data(), expected.data(), expected.data(), wave.size());
+    sut.processBlock(wave.data(), wave.data(), left.data(), right.data(), wave.size());
+    for (size_t i = 0; i < wave.size(); ++i)
+    {
+        ASSERT_NEAR(left[i], expected[i], 1E-5f);
+        ASSERT_EQ(left[i], right[i]);
+    }
+}
+
+TEST(DspBiquadFilterTest, smoothRampsIntoNewCoefficients)
+{
+    constexpr auto sampleRate{48000.0f};
+    constexpr size_t blockSize{64};
+    DSP::BiquadStereoSmooth<DSP::BiquadFilterType::LowPass> sut;
+    sut.setSmoothingSteps(0);
+    sut.computeCoefficients(sampleRate, 50.f, 10.f, 0.f);
+    std::vector<float> wave(48000, 0);
+    renderWithSineWave(wave, sampleRate, 997.f);
+    std::vector<float> out(blockSize, 0);
+    sut.processBlock(wave.data(), wave.data(), out.data(), out.data(), blockSize);
+
+    // a wide and resonant jump, the filters on the way stay stable
+    sut.setSmoothingSteps(1000);
+    sut.computeCoefficients(sampleRate, 15000.f, 10.f, 0.f);
+    DSP::BiquadCoefficients target;
+    target.coefficients(DSP::BiquadFilterType::LowPass, sampleRate, 15000.f, 10.f, 0.f);
+    for (size_t i = blockSize; i + blockSize <= wave.size(); i += blockSize)
+    {
+        sut.processBlock(wave.data() + i, wave.data() + i, out.data(), out.data(), blockSize);
+        for (const auto v : out)
+        {
+            ASSERT_LT(std::abs(v), 20.f);
+        }
+        if (i < 1000)
+        {
+            EXPECT_NE(sut.getCoefficients().a1, target.getCoefficients().a1);
+        }
+    }
+    EXPECT_EQ(sut.getCoefficients().b0, target.getCoefficients().b0);
+    EXPECT_EQ(sut.getCoefficients().a1, target.getCoefficients().a1);
+    EXPECT_EQ(sut.getCoefficients().a2, target.getCoefficients().a2);
+}
+
+template <typename Filter>
+concept CoefficientsSetDirectly = requires(Filter& filter) {
+    filter.coefficients(DSP::BiquadFilterType::LowPass, 48000.f, 1000.f, 0.707f, 0.f);
+};
+
+// a direct write would bypass the ramp and race with processBlock
+static_assert(CoefficientsSetDirectly<DSP::BiquadStereo<DSP::BiquadFilterType::LowPass>>);
+static_assert(!CoefficientsSetDirectly<DSP::BiquadStereoSmooth<DSP::BiquadFilterType::LowPass>>);
+
+// a resonant pole swept back and forth within two samples, a tdf-ii ramping a1 and a2 overflows on this
+TEST(DspBiquadFilterTest, smoothStaysBoundedOnFastResonantSweeps)
+{
+    constexpr auto sampleRate{48000.0f};
+    constexpr size_t blockSize{2};
+    DSP::BiquadStereoSmooth<DSP::BiquadFilterType::LowPass> sut;
+    sut.setSmoothingSteps(blockSize);
+    std::vector<float> wave(48000 * 2, 0);
+    renderWithSineWave(wave, sampleRate, 1000.f);
+    std::vector<float> left(blockSize, 0);
+    std::vector<float> right(blockSize, 0);
+    for (size_t i = 0; i + blockSize <= wave.size(); i += blockSize)
+    {
+        sut.computeCoefficients(sampleRate, (i / blockSize) % 2 ? 200.f : 10000.f, 20.f, 0.f);
+        sut.processBlock(wave.data() + i, wave.data() + i, left.data(), right.data(), blockSize);
+        for (const auto v : left)
+        {
+            ASSERT_TRUE(std::isfinite(v)) << i;
+            ASSERT_LT(std::abs(v), 1000.f) << i;
+        }
+    }
+}
+
+TEST(DspBiquadFilterTest, fastCoefficientMathMatchesExact)
+{
+    constexpr auto sampleRate{48000.0f};
+    for (const auto type : {DSP::BiquadFilterType::LowPass, DSP::BiquadFilterType::HighPass,
+                            DSP::BiquadFilterType::Peak, DSP::BiquadFilterType::LoShelf,
+                            DSP::BiquadFilterType::HiShelf})
+    {
+        for (float hz = 20.f; hz < 20000.f; hz *= 1.5f)
+        {
+            DSP::BiquadCoefficients exact;
+            DSP::BiquadCoefficients sut;
+            sut.setCoefficientMath(DSP::CoefficientMath::Fast);
+            exact.coefficients(type, sampleRate, hz, 0.707f, -9.f);
+            sut.coefficients(type, sampleRate, hz, 0.707f, -9.f);
+            for (float cf = 0.001f; cf < 0.5f; cf *= 1.3f)
+            {
+                EXPECT_NEAR(sut.magnitudeInDb(cf), exact.magnitudeInDb(cf), 0.01f) << hz << " @" << cf;
+            }
+        }
+    }
+}
+
+TEST(DspBiquadFilterTest, cachedCoefficientsMatchComputed)
+{
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadCoefficientCache cache;
+    DSP::BiquadCoefficients sut;
+    DSP::BiquadCoefficients reference;
+    sut.setCoefficientCache(&cache);
+    for (size_t round = 0; round < 2; ++round)
+    {
+        for (float hz = 20.f; hz < 20000.f; hz *= 1.5f)
+        {
+            sut.coefficients(DSP::BiquadFilterType::Peak, sampleRate, hz, 0.707f, 6.f);
+            reference.coefficients(DSP::BiquadFilterType::Peak, sampleRate, DSP::quantizeForCache(hz),
+                                   DSP::quantizeForCache(0.707f), DSP::quantizeForCache(6.f));
+            EXPECT_EQ(sut.getCoefficients().b0, reference.getCoefficients().b0);
+            EXPECT_EQ(sut.getCoefficients().a1, reference.getCoefficients().a1);
+            EXPECT_EQ(sut.getCoefficients().a2, reference.getCoefficients().a2);
+        }
+    }
+    EXPECT_GT(cache.hits(), 0u); // neighbouring frequencies may share a slot
+    EXPECT_EQ(cache.hits() + cache.misses(), 2 * 18u);
+}
+
+TEST(DspBiquadFilterTest, smoothUsesMathAndCache)
+{
+    constexpr auto sampleRate{48000.0f};
+    DSP::BiquadCoefficientCache cache;
+    DSP::BiquadStereoSmooth<DSP::BiquadFilterType::LowPass> sut;
+    sut.setSmoothingSteps(0);
+    sut.setCoefficientCache(&cache);
+    sut.setCoefficientMath(DSP::CoefficientMath::Fast);
+    DSP::BiquadCoefficients reference;
+    reference.setCoefficientMath(DSP::CoefficientMath::Fast);
+    std::array<float, 16> block{};
+    for (size_t round = 0; round < 2; ++round)
+    {
+        for (float hz = 20.f; hz < 20000.f; hz *= 1.5f)
+        {
+            sut.computeCoefficients(sampleRate, hz, 0.707f, 0.f);
+            sut.processBlock(block.data(), block.data(), block.data(), block.data(), block.size());
+            reference.coefficients(DSP::BiquadFilterType::LowPass, sampleRate, DSP::quantizeForCache(hz),
+                                   DSP::quantizeForCache(0.707f), DSP::quantizeForCache(0.f));
+            EXPECT_EQ(sut.getCoefficients().b0, reference.getCoefficients().b0);
+            EXPECT_EQ(sut.getCoefficients().a1, reference.getCoefficients().a1);
+        }
+    }
+    EXPECT_GE(cache.hits(), 18u);
+    EXPECT_EQ(cache.hits() + cache.misses(), 2 * 18u);
+}
+
+TEST(DspBiquadFilterTest, chebyshevCachedCoefficientsMatchComputed)
+{
+    constexpr auto sampleRate{48000.0f};
+    DSP::ChebyshevBiquad::Cache cache;
+    DSP::ChebyshevBiquad sut;
+    DSP::ChebyshevBiquad reference;
+    sut.setSampleRate(sampleRate);
+    reference.setSampleRate(sampleRate);
+    sut.setCoefficientCache(&cache);
+    std::vector<float> wave(4800, 0);
+    renderWithSineWave(wave, sampleRate, 997.f);
+    std::vector<float> expected(wave.size(), 0);
+    std::vector<float> out(wave.size(), 0);
+    for (size_t round = 0; round < 2; ++round)
+    {
+        for (size_t order = 1; order <= DSP::ChebyshevBiquad::MAX_ORDER; ++order)
+        {
+            const auto fc = 1234.5f;
+            sut.computeType2(order, fc, 3, round == 0);
+            reference.computeType2(order, DSP::quantizeForCache(fc), DSP::quantizeForCache(3.f), round == 0);
+            sut.processBlock(wave.data(), out.data(), wave.size());
+            reference.processBlock(wave.data(), expected.data(), wave.size());
+            EXPECT_EQ(out, expected) << "order " << order;
+
+            sut.computeType2(order, fc, 3, round == 0); // a hit
+            reference.computeType2(order, DSP::quantizeForCache(fc), DSP::quantizeForCache(3.f), round == 0);
+            sut.processBlock(wave.data(), out.data(), wave.size());
+            reference.processBlock(wave.data(), expected.data(), wave.size());
+            EXPECT_EQ(out, expected) << "order " << order;
+        }
+    }
+    EXPECT_EQ(cache.misses(), 2 * DSP::ChebyshevBiquad::MAX_ORDER);
+    EXPECT_EQ(cache.hits(), 2 * DSP::ChebyshevBiquad::MAX_ORDER);
+}
+
+TEST(DspBiquadFilterTest, magnitudeResponseMatchesSinglePoints)
+{
+    DSP::BiquadCoefficients sut;
+    std::vector<float> frequencies;
+    for (float cf = 0.0005f; cf < 0.5f; cf *= 1.05f)
+    {
+        frequencies.push_back(cf);
+    }
+    std::vector<float> db(frequencies.size(), 0);
+    for (const auto type : {DSP::BiquadFilterType::LowPass, DSP::BiquadFilterType::HighPass,
+                            DSP::BiquadFilterType::Peak, DSP::BiquadFilterType::HiShelf})
+    {
+        sut.coefficients(type, 48000.f, 1000.f, 2.f, -6.f);
+        sut.magnitudeResponse(frequencies, db);
+        for (size_t i = 0; i < frequencies.size(); ++i)
+        {
+            EXPECT_NEAR(db[i], sut.magnitudeInDb(frequencies[i]), 0.01f) << "@" << frequencies[i];
+        }
+    }
+}
+
+TEST(DspBiquadFilterTest, chebyshevMagnitudeResponseMatchesSinglePoints)
+{
+    DSP::ChebyshevBiquad sut;
+    sut.setSampleRate(48000.f);
+    std::vector<float> frequencies;
+    for (float hz = 20.f; hz < 22000.f; hz *= 1.05f)
+    {
+        frequencies.push_back(hz);
+    }
+    std::vector<float> db(frequencies.size(), 0);
+    for (size_t order = 1; order <= DSP::ChebyshevBiquad::MAX_ORDER; ++order)
+    {
+        sut.computeType1(order, 2000, 3, order % 2 == 0);
+        sut.magnitudeResponse(frequencies, db);
+        for (size_t i = 0; i < frequencies.size(); ++i)
+        {
+            EXPECT_NEAR(db[i], sut.getMagnitudeInDb(frequencies[i]), 0.01f)
+                << "order " << order << " @" << frequencies[i];
+        }
+    }
+}
+
 TEST(DISABLED_DspBiquadFilterTest, coefficientTables)
 {
     DSP::ChebyshevBiquad sut;
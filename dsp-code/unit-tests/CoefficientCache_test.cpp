@@ -0,0 +1,30 @@
+#include "CoefficientCache.h"
+
+#include "gtest/gtest.h"
+
+namespace DspTest
+{
+
+TEST(DspCoefficientCacheTest, findsInsertedValues)
+{
+    DSP::CoefficientCache<2, float, 16> sut;
+    EXPECT_EQ(sut.find({1, 2}), nullptr);
+    sut.insert({1, 2}, 42.f);
+    ASSERT_NE(sut.find({1, 2}), nullptr);
+    EXPECT_EQ(*sut.find({1, 2}), 42.f);
+    EXPECT_EQ(sut.find({2, 1}), nullptr);
+    EXPECT_EQ(sut.hits(), 2u);
+    EXPECT_EQ(sut.misses(), 2u);
+
+    sut.clear();
+    EXPECT_EQ(sut.find({1, 2}), nullptr);
+}
+
+TEST(DspCoefficientCacheTest, quantizeKeepsCloseValuesTogether)
+{
+    EXPECT_EQ(DSP::quantizeForCache(1000.f), DSP::quantizeForCache(1000.1f));
+    EXPECT_NE(DSP::quantizeForCache(1000.f), DSP::quantizeForCache(1001.f));
+    EXPECT_EQ(DSP::quantizeForCache(0.f), 0.f);
+    EXPECT_NEAR(DSP::quantizeForCache(-3.f), -3.f, 3.f * 0.00025f);
+}
+}
@@ -0,0 +1,86 @@
+#include "Biquad.h"
+#include "CpuDispatch.h"
+#include "CrossFader.h"
+#include "OnePoleFilter.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace DspTest
+{
+
+TEST(DspCpuDispatchTest, detectedIsaIsSupported)
+{
+    EXPECT_TRUE(DSP::isSupported(DSP::Isa::Generic));
+    EXPECT_TRUE(DSP::isSupported(DSP::detectIsa()));
+    EXPECT_EQ(DSP::activeIsa(), DSP::detectIsa());
+
+    EXPECT_TRUE(DSP::forceIsa(DSP::Isa::Generic));
+    EXPECT_EQ(DSP::activeIsa(), DSP::Isa::Generic);
+    for (const auto isa : {DSP::Isa::Avx2, DSP::Isa::Avx512})
+    {
+        EXPECT_EQ(DSP::forceIsa(isa), DSP::isSupported(isa));
+    }
+    DSP::resetIsa();
+    EXPECT_EQ(DSP::activeIsa(), DSP::detectIsa());
+}
+
+TEST(DspCpuDispatchTest, allVariantsComputeTheSame)
+{
+    constexpr size_t NumChannels{8};
+    constexpr size_t numSamples{1000};
+    std::minstd_rand generator(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::vector<float> source(numSamples + 3);
+    std::generate(source.begin(), source.end(), [&]() { return distribution(generator); });
+
+    // all kernels for one instruction set, appended into one vector
+    const auto render = [&source]()
+    {
+        std::vector<float> result;
+        std::vector<float> out(numSamples, 0);
+
+        DSP::BiquadBank<DSP::BiquadFilterType::Peak, NumChannels> bank;
+        bank.computeCoefficients(48000.f, 1000.f, 0.707f, 6.f);
+        std::vector<float> interleaved(numSamples * NumChannels, 0);
+        for (size_t i = 0; i < interleaved.size(); ++i)
+        {
+            interleaved[i] = source[i % numSamples];
+        }
+        bank.processBlockInterleaved(interleaved.data(), interleaved.data(), numSamples);
+        result.insert(result.end(), interleaved.begin(), interleaved.end());
+
+        DSP::OnePoleFilterOptimized onePole(48000.f, 1000.f);
+        onePole.processBlock(source.data(), out.data(), numSamples);
+        result.insert(result.end(), out.begin(), out.end());
+
+        DSP::CrossFader fader;
+        fader.reset(numSamples / 2);
+        fader.processBlock(source.data(), source.data() + 1, out.data(), numSamples);
+        result.insert(result.end(), out.begin(), out.end());
+        return result;
+    };
+
+    ASSERT_TRUE(DSP::forceIsa(DSP::Isa::Generic));
+    const auto expected = render();
+    for (const auto isa : {DSP::Isa::Avx2, DSP::Isa::Avx512})
+    {
+        if (!DSP::forceIsa(isa))
+        {
+            continue;
+        }
+        const auto result = render();
+        ASSERT_EQ(result.size(), expected.size());
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            // fma contraction may round differently
+            ASSERT_NEAR(result[i], expected[i], 1E-5f) << "isa " << static_cast<int>(isa) << " index " << i;
+        }
+    }
+    DSP::resetIsa();
+}
+}
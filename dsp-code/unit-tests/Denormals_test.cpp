@@ -0,0 +1,108 @@
+#include "Biquad.h"
+#include "Denormals.h"
+#include "DigitalDelay.h"
+#include "OnePoleFilter.h"
+#include "TwoLatticeAllPass.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace DspTest
+{
+
+TEST(DspDenormalsTest, scopedGuardFlushesAndRestores)
+{
+    if (!DSP::ScopedFlushDenormals::isAvailable())
+    {
+        GTEST_SKIP() << "the floating point mode of this platform is unknown";
+    }
+    volatile float smallest = std::numeric_limits<float>::min();
+    {
+        DSP::ScopedFlushDenormals guard;
+        EXPECT_EQ(smallest / 4, 0.f);
+    }
+    EXPECT_EQ(std::fpclassify(smallest / 4), FP_SUBNORMAL);
+}
+
+TEST(DspDenormalsTest, flushDenormal)
+{
+    EXPECT_EQ(DSP::flushDenormal(std::numeric_limits<float>::denorm_min()), 0.f);
+    EXPECT_EQ(DSP::flushDenormal(-std::numeric_limits<float>::min()), 0.f);
+    EXPECT_EQ(DSP::flushDenormal(-1e-16f), 0.f);
+    EXPECT_EQ(DSP::flushDenormal(1e-14f), 1e-14f);
+    EXPECT_EQ(DSP::flushDenormal(-0.5f), -0.5f);
+}
+
+TEST(DspDenormalsTest, filtersFlushTheirStateOnRequest)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::OnePoleFilter onePole(sampleRate, 100.f);
+    DSP::Biquad<DSP::BiquadFilterType::LowPass> biquad;
+    biquad.computeCoefficients(sampleRate, 100.f, 0.707f, 0.f);
+    DSP::TwoLatticeAllPass<1000> allPass(sampleRate);
+    allPass.setSize(700);
+    allPass.setFeedback(0.7f);
+    onePole.setFlushDenormals(true);
+    biquad.setFlushDenormals(true);
+    allPass.setFlushDenormals(true);
+
+    // an impulse and 10 seconds of silence, without flushing the tails would be subnormal by then
+    std::array<float, 128> impulse{};
+    impulse[0] = 1.f;
+    std::array<float, 128> block{};
+    for (size_t i = 0; i < 48000 * 10 / block.size(); ++i)
+    {
+        onePole.processBlock(impulse.data(), block.data(), block.size());
+        impulse[0] = 0.f;
+        biquad.processBlock(block.data(), block.size());
+        allPass.processBlockInplace(block.data(), block.size());
+    }
+    for (const auto value : block)
+    {
+        ASSERT_EQ(value, 0.f);
+    }
+}
+
+TEST(DspDenormalsTest, delaysFlushTheirFeedbackTailOnRequest)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::DigitalDelay<100> delay(sampleRate);
+    delay.setTime(0.01f);
+    delay.setFlushDenormals(true);
+    // the flushing is kept when the buffer grows
+    DSP::GrowingDigitalDelay<2000> growing(sampleRate);
+    growing.setFlushDenormals(true);
+    growing.setTime(1.f);
+    ASSERT_TRUE(growing.grow());
+    std::array<float, 64> block{};
+    growing.processBlock(block.data(), block.data(), block.size());
+    growing.setTime(0.01f);
+
+    // an impulse circulating with a feedback of 0.5, without flushing the tail passes through the subnormals
+    std::array<float, 64> impulse{};
+    impulse[0] = 1.f;
+    std::array<float, 64> feedback{};
+    std::array<float, 64> growingFeedback{};
+    for (size_t i = 0; i < 48000 * 10 / block.size(); ++i)
+    {
+        for (size_t s = 0; s < block.size(); ++s)
+        {
+            feedback[s] = impulse[s] + 0.5f * feedback[s];
+            growingFeedback[s] = impulse[s] + 0.5f * growingFeedback[s];
+        }
+        impulse[0] = 0.f;
+        delay.processBlock(feedback.data(), feedback.data(), feedback.size());
+        growing.processBlock(growingFeedback.data(), growingFeedback.data(), growingFeedback.size());
+        for (size_t s = 0; s < block.size(); ++s)
+        {
+            ASSERT_NE(std::fpclassify(feedback[s]), FP_SUBNORMAL) << "block " << i;
+            ASSERT_NE(std::fpclassify(growingFeedback[s]), FP_SUBNORMAL) << "block " << i;
+        }
+    }
+    EXPECT_TRUE(std::all_of(feedback.begin(), feedback.end(), [](const float v) { return v == 0.f; }));
+}
+}
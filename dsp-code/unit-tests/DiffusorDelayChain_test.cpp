@@ -0,0 +1,277 @@
+#include "AudioProcessing.h"
+#include "DiffusorDelayChain.h"
+#include "TwoLatticeAllPass.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace DspTest
+{
+
+namespace
+{
+constexpr std::array<size_t, 5> ElementSizes{172, 229, 447, 611, 1176};
+}
+
+static_assert(DSP::getUsefulPrime(101, 172) == 173);
+static_assert(DSP::isPrimeNumber(8191) && !DSP::isPrimeNumber(8193));
+
+TEST(DiffusorDelayChainTest, primeTableMatchesTrialDivision)
+{
+    for (unsigned n = 0; n < DSP::PrimeTableSize + 1000; ++n)
+    {
+        ASSERT_EQ(DSP::isPrimeNumber(n), DSP::isPrimeByTrialDivision(n)) << n;
+        auto expected = std::max(n | 1u, 3u);
+        while (!DSP::isPrimeByTrialDivision(expected))
+        {
+            expected += 2;
+        }
+        ASSERT_EQ(DSP::getUsefulPrime(0, n), expected) << n;
+    }
+}
+
+TEST(DiffusorDelayChainTest, lengthsFollowTheSampleRate)
+{
+    // the sizes of KindOfADelay are primes already at 48 kHz
+    constexpr std::array<size_t, 10> widths{172, 229, 447, 611, 1176, 182, 219, 437, 631, 1098};
+    constexpr auto lengths = DSP::computeDiffusorLengths(widths, 48000.f);
+    for (size_t i = 0; i < widths.size(); ++i)
+    {
+        EXPECT_EQ(lengths[i], DSP::getUsefulPrime(101, static_cast<unsigned>(widths[i])));
+    }
+    for (const float sampleRate : {22050.f, 44100.f, 96000.f, 192000.f})
+    {
+        const auto scaled = DSP::computeDiffusorLengths(widths, sampleRate);
+        for (size_t i = 0; i < widths.size(); ++i)
+        {
+            EXPECT_TRUE(DSP::isPrimeNumber(static_cast<unsigned>(scaled[i])));
+            EXPECT_GE(scaled[i], 101u);
+            EXPECT_NEAR(static_cast<float>(scaled[i]), std::max(widths[i] * sampleRate / 48000.f, 101.f), 30.f);
+            EXPECT_EQ(std::count(scaled.begin(), scaled.end(), scaled[i]), 1);
+        }
+    }
+    // widths that would end up at the same prime, e.g. all below the minimum
+    const auto distinct = DSP::computeDiffusorLengths(std::array<size_t, 4>{10, 20, 172, 173}, 48000.f);
+    EXPECT_EQ(distinct, (std::array<size_t, 4>{101, 103, 173, 179}));
+}
+
+TEST(DiffusorDelayChainTest, lengthsStayPrimeWithinTheDelayLine)
+{
+    // at 192 kHz the two longest widths exceed a delay line of 2000, they take the largest primes below it
+    constexpr std::array<size_t, 5> widths{172, 229, 447, 611, 1176};
+    constexpr auto lengths = DSP::computeDiffusorLengths(widths, 192000.f, 2000);
+    static_assert(DSP::getPrimeAtMost(2000) == 1999 && DSP::getPrimeAtMost(1998) == 1997);
+    EXPECT_EQ(lengths, (std::array<size_t, 5>{691, 919, 1789, 1999, 1997}));
+    EXPECT_EQ(DSP::computeDiffusorLengths<1>({611}, 192000.f, 2000)[0], 1999u);
+}
+
+// the chain processed sub-block by sub-block gives the same as one allpass after the other over the whole block
+TEST(DiffusorDelayChainTest, matchesTwoLatticeAllPasses)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::DiffusorDelayChain<5000, 5> sut{sampleRate};
+    sut.setMix(0.5f);
+    std::vector<DSP::TwoLatticeAllPass<5000>> allPasses(5, DSP::TwoLatticeAllPass<5000>(sampleRate));
+    for (size_t element = 0; element < ElementSizes.size(); ++element)
+    {
+        sut.setElementSize(element, ElementSizes[element]);
+        allPasses[element].setSize(sut.getUsefulPrime(101, static_cast<unsigned>(ElementSizes[element])));
+        allPasses[element].setFeedback(0.65f);
+        allPasses[element].setLowpassCutoff(8000.f);
+    }
+    const auto mix = DSP::getMixFactor(0.5f);
+
+    std::vector<float> source(48000);
+    DSP::renderSine(source, sampleRate, 440.f);
+    source[0] = 1.f;
+    std::vector<float> result(source.size());
+    std::vector<float> expected(source.size());
+    constexpr std::array<size_t, 4> blockSizes{16, 1, 333, 128};
+    for (size_t index = 0, round = 0; index < source.size(); ++round)
+    {
+        const auto blockSize = std::min(blockSizes[round % blockSizes.size()], source.size() - index);
+        sut.processBlock(source.data() + index, result.data() + index, blockSize);
+        std::copy_n(source.data() + index, blockSize, expected.data() + index);
+        for (auto& allPass : allPasses)
+        {
+            allPass.processBlockInplace(expected.data() + index, blockSize);
+        }
+        for (size_t i = index; i < index + blockSize; ++i)
+        {
+            expected[i] = source[i] * mix.left + expected[i] * mix.right;
+        }
+        index += blockSize;
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_EQ(result[i], expected[i]) << i;
+    }
+}
+
+TEST(DiffusorDelayChainTest, sharedArena)
+{
+    constexpr float sampleRate{44100.f};
+    using Diffusor = DSP::DiffusorDelayChain<2000, 5>;
+    DSP::DiffusorArena arena{Diffusor::ArenaSize * 2};
+    std::array<Diffusor, 2> shared{Diffusor(sampleRate, arena), Diffusor(sampleRate, arena)};
+    std::array<Diffusor, 2> own{Diffusor(sampleRate), Diffusor(sampleRate)};
+    for (size_t element = 0; element < ElementSizes.size(); ++element)
+    {
+        shared[0].setElementSize(element, ElementSizes[element]);
+        own[0].setElementSize(element, ElementSizes[element]);
+        shared[1].setElementSize(element, ElementSizes[element] + 10);
+        own[1].setElementSize(element, ElementSizes[element] + 10);
+    }
+
+    std::vector<float> source(20000);
+    DSP::renderSine(source, sampleRate, 1000.f);
+    std::array<std::vector<float>, 2> result{source, source};
+    std::array<std::vector<float>, 2> expected{source, source};
+    for (size_t index = 0; index < source.size(); index += 16)
+    {
+        for (size_t chain = 0; chain < 2; ++chain)
+        {
+            shared[chain].processBlock(source.data() + index, result[chain].data() + index, 16);
+            own[chain].processBlock(source.data() + index, expected[chain].data() + index, 16);
+        }
+    }
+    EXPECT_EQ(result[0], expected[0]);
+    EXPECT_EQ(result[1], expected[1]);
+    EXPECT_NE(result[0], result[1]);
+}
+
+TEST(DiffusorDelayChainTest, dryWithoutMix)
+{
+    DSP::DiffusorDelayChain<1000, 3> sut{48000.f};
+    sut.setMix(0.f);
+    std::vector<float> source(256);
+    DSP::renderSine(source, 48000.f, 1000.f);
+    std::vector<float> result(source.size());
+    sut.processBlock(source.data(), result.data(), source.size());
+    EXPECT_EQ(result, source);
+}
+
+TEST(DiffusorDelayChainTest, setElementSizesAtOnce)
+{
+    constexpr float sampleRate{96000.f};
+    DSP::DiffusorDelayChain<5000, 5> sut{sampleRate};
+    DSP::DiffusorDelayChain<5000, 5> expected{sampleRate};
+    sut.setElementSizes(ElementSizes);
+    for (size_t element = 0; element < ElementSizes.size(); ++element)
+    {
+        expected.setElementSize(element, ElementSizes[element]);
+    }
+    std::vector<float> source(9600);
+    DSP::renderSine(source, sampleRate, 1000.f);
+    source[0] = 1.f;
+    std::vector<float> result(source.size());
+    std::vector<float> expectedResult(source.size());
+    sut.processBlock(source.data(), result.data(), source.size());
+    expected.processBlock(source.data(), expectedResult.data(), source.size());
+    EXPECT_EQ(result, expectedResult);
+}
+
+// without mixing between the stages, each channel is a chain of its own
+TEST(DiffusorNetworkTest, matchesDiffusorDelayChains)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::DiffusorNetwork<5000, 5, 2> sut{sampleRate};
+    sut.setMix(0.6f);
+    using Diffusor = DSP::DiffusorDelayChain<5000, 5>;
+    std::array<Diffusor, 2> chains{Diffusor(sampleRate), Diffusor(sampleRate)};
+    for (size_t c = 0; c < chains.size(); ++c)
+    {
+        chains[c].setMix(0.6f);
+        for (size_t element = 0; element < ElementSizes.size(); ++element)
+        {
+            sut.setElementSize(c, element, ElementSizes[element] + c * 20);
+            chains[c].setElementSize(element, ElementSizes[element] + c * 20);
+        }
+    }
+
+    std::array<std::vector<float>, 2> source{std::vector<float>(48000), std::vector<float>(48000)};
+    DSP::renderSine(source[0], sampleRate, 440.f);
+    DSP::renderSine(source[1], sampleRate, 1250.f);
+    source[0][0] = 1.f;
+    auto result = source;
+    auto expected = source;
+    constexpr std::array<size_t, 4> blockSizes{16, 1, 333, 128};
+    for (size_t index = 0, round = 0; index < source[0].size(); ++round)
+    {
+        const auto blockSize = std::min(blockSizes[round % blockSizes.size()], source[0].size() - index);
+        std::array<const float*, 2> in{source[0].data() + index, source[1].data() + index};
+        std::array<float*, 2> out{result[0].data() + index, result[1].data() + index};
+        sut.processBlock(in.data(), out.data(), blockSize);
+        for (size_t c = 0; c < chains.size(); ++c)
+        {
+            chains[c].processBlock(source[c].data() + index, expected[c].data() + index, blockSize);
+        }
+        index += blockSize;
+    }
+    for (size_t c = 0; c < chains.size(); ++c)
+    {
+        for (size_t i = 0; i < source[c].size(); ++i)
+        {
+            ASSERT_EQ(result[c][i], expected[c][i]) << c << " " << i;
+        }
+    }
+}
+
+// an impulse into one channel spreads to all of them with the stages mixed, without the others stay silent
+// without the lowpass each channel is an allpass and the hadamard matrix is orthogonal, so the energy stays the same
+TEST(DiffusorNetworkTest, stageMixingSpreadsAndKeepsEnergy)
+{
+    constexpr float sampleRate{48000.f};
+    constexpr size_t numChannels{8};
+    for (const bool mixing : {false, true})
+    {
+        DSP::DiffusorNetwork<2000, 4, numChannels> sut{sampleRate};
+        sut.setMix(1.f);
+        sut.setCutoff(sampleRate);
+        sut.setStageMixing(mixing);
+        for (size_t c = 0; c < numChannels; ++c)
+        {
+            for (size_t stage = 0; stage < 4; ++stage)
+            {
+                sut.setElementSize(c, stage, 150 + stage * 233 + c * 37);
+            }
+        }
+        std::array<std::vector<float>, numChannels> data;
+        std::array<float*, numChannels> channels{};
+        for (size_t c = 0; c < numChannels; ++c)
+        {
+            data[c].assign(96000, 0.f);
+            channels[c] = data[c].data();
+        }
+        data[0][0] = 1.f;
+        for (size_t index = 0; index < data[0].size(); index += 32)
+        {
+            std::array<float*, numChannels> block{};
+            std::transform(channels.begin(), channels.end(), block.begin(), [&](float* c) { return c + index; });
+            sut.processBlock(block.data(), block.data(), 32);
+        }
+        double energy{0};
+        for (size_t c = 0; c < numChannels; ++c)
+        {
+            double channelEnergy{0};
+            for (const auto value : data[c])
+            {
+                channelEnergy += static_cast<double>(value) * value;
+            }
+            if (mixing || c == 0)
+            {
+                EXPECT_GT(channelEnergy, 0.01) << c;
+            }
+            else
+            {
+                EXPECT_EQ(channelEnergy, 0.0) << c;
+            }
+            energy += channelEnergy;
+        }
+        EXPECT_NEAR(energy, 1.0, 1E-3) << mixing;
+    }
+}
+}
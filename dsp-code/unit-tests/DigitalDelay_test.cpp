@@ -6,7 +6,11 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
 #include <numbers>
+#include <thread>
+#include <vector>
 
 
 namespace DspTest
@@ -47,6 +51,23 @@ TEST(DigitalDelayTest, response)
     }
 }
 
+// the default delay time of 250 msecs doesn't fit a 100 msecs buffer, the first fade starts within it
+TEST(DigitalDelayTest, shortBufferFadesFromWithinTheBuffer)
+{
+    DSP::DigitalDelay<100> sut{48000.f};
+    sut.setTime(0.01f);
+    std::array<float, 64> block{};
+    block[0] = 1.f;
+    for (size_t i = 0; i < 200; ++i)
+    {
+        sut.processBlock(block.data(), block.data(), block.size());
+        for (const auto value : block)
+        {
+            ASSERT_TRUE(std::isfinite(value) && std::abs(value) <= 1.f) << "block " << i;
+        }
+    }
+}
+
 // assume that we do not the phase of the modulation
 TEST(DigitalDelayTest, modulation)
 {
@@ -85,4 +106,480 @@ TEST(DigitalDelayTest, modulation)
     EXPECT_LT(minPeriod, 80);
     EXPECT_GT(maxPeriod, 134);
 }
+
+TEST(DigitalDelayTest, powerOfTwoResponse)
+{
+    DSP::DigitalDelay<1000, DSP::DelayWrapping::PowerOfTwo> sut{10000.f};
+    EXPECT_EQ(sut.m_buffer.size(), 16384);
+    EXPECT_EQ(sut.memoryInBytes(), 16384 * sizeof(float));
+    sut.setModulationSpeed(0.0f);
+    sut.setModulationDepth(0.0f);
+    sut.setTime(0.01);
+    std::array<float, 1024> feedEmpty{};
+    std::array<float, 1024> target{};
+    for (size_t i = 0; i < 4; ++i)
+    {
+        sut.processBlock(feedEmpty.data(), target.data(), target.size());
+    }
+
+    std::array<float, 1024> source{};
+    source[0] = 1;
+    source[1] = -0.5f;
+    source[2] = 0.25f;
+    source[3] = -0.125f;
+    sut.processBlock(source.data(), target.data(), target.size());
+    for (size_t i = 0; i < 96; ++i)
+    {
+        EXPECT_EQ(target[i], 0);
+    }
+    EXPECT_NE(target[98], 0);
+    EXPECT_NE(target[99], 0);
+    EXPECT_NE(target[100], 0);
+    EXPECT_NE(target[101], 0);
+    EXPECT_NE(target[102], 0);
+    for (size_t i = 105; i < target.size(); ++i)
+    {
+        EXPECT_EQ(target[i], 0);
+    }
+}
+
+// the same modulated delay read with masks instead of a modulo and the guard copy, several times around the buffer
+TEST(DigitalDelayTest, powerOfTwoMatchesModulo)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::DigitalDelay<1000> modulo{sampleRate};
+    DSP::DigitalDelay<1000, DSP::DelayWrapping::PowerOfTwo> powerOfTwo{sampleRate};
+    modulo.setModulationSpeed(3.f);
+    modulo.setModulationDepth(20.f);
+    powerOfTwo.setModulationSpeed(3.f);
+    powerOfTwo.setModulationDepth(20.f);
+    modulo.setTime(0.05f);
+    powerOfTwo.setTime(0.05f);
+
+    std::vector<float> source(48000 * 3);
+    DSP::renderSine(source, sampleRate, 440.f);
+    std::vector<float> expected(source.size());
+    std::vector<float> result(source.size());
+    constexpr size_t blockSize{100};
+    for (size_t index = 0; index < source.size(); index += blockSize)
+    {
+        modulo.processBlock(source.data() + index, expected.data() + index, blockSize);
+        powerOfTwo.processBlock(source.data() + index, result.data() + index, blockSize);
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        // the modulo version rounds head - delay to a float, at a head of 40000 that is 1/256 of a sample
+        ASSERT_NEAR(result[i], expected[i], 1E-3f) << i;
+    }
+}
+
+namespace
+{
+// the block path against step() per sample: around the buffer, through time changes and with a delay so short
+// that the block falls back to single steps
+template <typename Delay>
+void expectBlockMatchesStep(const DSP::DelayTimeChange timeChange)
+{
+    constexpr float sampleRate{48000.f};
+    Delay stepped{sampleRate};
+    Delay blocked{sampleRate};
+    for (auto* delay : {&stepped, &blocked})
+    {
+        delay->setModulationSpeed(2.f);
+        delay->setModulationDepth(30.f);
+        delay->setTimeChange(timeChange);
+        delay->setTime(0.3f);
+    }
+
+    std::vector<float> source(48000 * 3);
+    DSP::renderSine(source, sampleRate, 330.f);
+    std::vector<float> result(source.size());
+    constexpr std::array<size_t, 4> blockSizes{1, 37, 128, 500};
+    // a chunk snaps to the end of the glide at its end, sample by sample it snaps up to a chunk earlier
+    const auto tolerance = timeChange == DSP::DelayTimeChange::Glide ? 1E-3f : 1E-6f;
+    for (size_t index = 0, round = 0; index < source.size(); ++round)
+    {
+        if (round == 100)
+        {
+            stepped.setTime(0.05f);
+            blocked.setTime(0.05f);
+            stepped.setTime(0.7f); // scheduled after the first change
+            blocked.setTime(0.7f);
+        }
+        if (round == 400)
+        {
+            stepped.setTime(0.00005f);
+            blocked.setTime(0.00005f);
+            stepped.setModulationDepth(0.f);
+            blocked.setModulationDepth(0.f);
+        }
+        const auto blockSize = std::min(blockSizes[round % blockSizes.size()], source.size() - index);
+        blocked.processBlock(source.data() + index, result.data() + index, blockSize);
+        for (size_t i = index; i < index + blockSize; ++i)
+        {
+            ASSERT_NEAR(result[i], stepped.step(source[i]), tolerance) << i;
+        }
+        index += blockSize;
+    }
+}
+}
+
+TEST(DigitalDelayTest, blockMatchesStep)
+{
+    for (const auto timeChange :
+         {DSP::DelayTimeChange::Crossfade, DSP::DelayTimeChange::AdaptiveCrossfade, DSP::DelayTimeChange::Glide})
+    {
+        expectBlockMatchesStep<DSP::DigitalDelay<1000>>(timeChange);
+        expectBlockMatchesStep<DSP::DigitalDelay<1000, DSP::DelayWrapping::PowerOfTwo>>(timeChange);
+    }
+    expectBlockMatchesStep<DSP::DigitalDelay<1000, DSP::DelayWrapping::Modulo, DSP::DelayStorage::Int16>>(
+        DSP::DelayTimeChange::Crossfade);
+    expectBlockMatchesStep<DSP::DigitalDelay<1000, DSP::DelayWrapping::PowerOfTwo, DSP::DelayStorage::Half>>(
+        DSP::DelayTimeChange::Crossfade);
+}
+
+TEST(DigitalDelayTest, blockInPlace)
+{
+    DSP::DigitalDelay<1000> sut{10000.f};
+    sut.setModulationDepth(0.f);
+    sut.setTime(0.01f);
+    std::array<float, 10000> data{};
+    sut.processBlock(data.data(), data.data(), data.size());
+    data[0] = 1.f;
+    sut.processBlock(data.data(), data.data(), data.size());
+    const auto peak = std::max_element(data.begin(), data.end()) - data.begin();
+    EXPECT_NEAR(peak, 100, 2);
+}
+
+// each tap gives what a DigitalDelay with its settings gives, through time changes and a tap short enough for the
+// fallback to single steps
+TEST(DigitalDelayTest, multiTapMatchesSeparateDelays)
+{
+    constexpr float sampleRate{48000.f};
+    constexpr size_t NumTaps{3};
+    DSP::MultiTapDelay<1000, NumTaps> sut{sampleRate};
+    std::array<DSP::DigitalDelay<1000>, NumTaps> delays{DSP::DigitalDelay<1000>(sampleRate),
+                                                        DSP::DigitalDelay<1000>(sampleRate),
+                                                        DSP::DigitalDelay<1000>(sampleRate)};
+    const std::array<float, NumTaps> times{0.1f, 0.25f, 0.4f};
+    const std::array<float, NumTaps> pans{-1.f, 0.3f, 1.f};
+    std::array<DSP::PanValues<float>, NumTaps> gains{};
+    for (size_t tap = 0; tap < NumTaps; ++tap)
+    {
+        const auto speed = 0.5f + static_cast<float>(tap);
+        const auto depth = 10.f * static_cast<float>(tap);
+        sut.setTime(tap, times[tap]);
+        sut.setModulationSpeed(tap, speed);
+        sut.setModulationDepth(tap, depth);
+        sut.setGainAndPan(tap, 0.5f, pans[tap]);
+        delays[tap].setTime(times[tap]);
+        delays[tap].setModulationSpeed(speed);
+        delays[tap].setModulationDepth(depth);
+        const auto pan = DSP::getPanFactor(pans[tap]);
+        gains[tap] = {pan.left * 0.5f, pan.right * 0.5f};
+    }
+
+    std::vector<float> source(48000 * 2);
+    DSP::renderSine(source, sampleRate, 220.f);
+    std::vector<float> left(source.size());
+    std::vector<float> right(source.size());
+    std::vector<float> delayed(source.size());
+    std::vector<float> expectedLeft(source.size(), 0.f);
+    std::vector<float> expectedRight(source.size(), 0.f);
+    constexpr size_t blockSize{100};
+    for (size_t index = 0; index < source.size(); index += blockSize)
+    {
+        if (index == 30000)
+        {
+            sut.setTime(1, 0.00005f);
+            delays[1].setTime(0.00005f);
+        }
+        sut.processBlock(source.data() + index, left.data() + index, right.data() + index, blockSize);
+        for (size_t tap = 0; tap < NumTaps; ++tap)
+        {
+            delays[tap].processBlock(source.data() + index, delayed.data() + index, blockSize);
+            for (size_t i = index; i < index + blockSize; ++i)
+            {
+                expectedLeft[i] += gains[tap].left * delayed[i];
+                expectedRight[i] += gains[tap].right * delayed[i];
+            }
+        }
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_NEAR(left[i], expectedLeft[i], 1E-6f) << i;
+        ASSERT_NEAR(right[i], expectedRight[i], 1E-6f) << i;
+    }
+    EXPECT_EQ(sut.memoryInBytes(), delays[0].memoryInBytes());
+}
+
+namespace
+{
+// a ramp as input, the b-spline reproduces it, so the output tells the delay of each sample
+// (the delay time minus one, the read is before the write of the same sample)
+std::vector<float> delayTimesAfterChanges(DSP::DigitalDelay<1000>& sut,
+                                          const std::vector<std::pair<size_t, float>>& changes, const size_t numSamples)
+{
+    std::vector<float> ramp(numSamples);
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        ramp[i] = static_cast<float>(i);
+    }
+    std::vector<float> result(numSamples);
+    size_t index{0};
+    for (const auto& [at, seconds] : changes)
+    {
+        sut.processBlock(ramp.data() + index, result.data() + index, at - index);
+        sut.setTime(seconds);
+        index = at;
+    }
+    sut.processBlock(ramp.data() + index, result.data() + index, numSamples - index);
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        result[i] = ramp[i] - result[i];
+    }
+    return result;
+}
+}
+
+TEST(DigitalDelayTest, glideIsBoundedAndReachesTheTarget)
+{
+    DSP::DigitalDelay<1000> sut{10000.f};
+    sut.setTimeChange(DSP::DelayTimeChange::Glide);
+    // from the default 2500 samples, an automation burst and a final jump to 500 samples
+    const auto delayTimes =
+        delayTimesAfterChanges(sut, {{3000, 0.2f}, {3100, 0.21f}, {3200, 0.15f}, {3300, 0.3f}, {4000, 0.05f}}, 20000);
+    for (size_t i = 2500; i < 3000; ++i)
+    {
+        ASSERT_NEAR(delayTimes[i], 2499.f, 1E-2f) << i;
+    }
+    for (size_t i = 3001; i < delayTimes.size(); ++i)
+    {
+        ASSERT_LE(std::abs(delayTimes[i] - delayTimes[i - 1]), 0.5f + 1E-2f) << i;
+    }
+    EXPECT_LT(delayTimes[3100], 2499.f);
+    EXPECT_NEAR(delayTimes.back(), 499.f, 1E-2f);
+}
+
+TEST(DigitalDelayTest, adaptiveCrossfadeFollowsTheJump)
+{
+    for (const auto timeChange : {DSP::DelayTimeChange::Crossfade, DSP::DelayTimeChange::AdaptiveCrossfade})
+    {
+        DSP::DigitalDelay<1000> sut{10000.f};
+        sut.setTimeChange(timeChange);
+        // a jump of 100 samples fades in 256 samples instead of 8192
+        const auto delayTimes = delayTimesAfterChanges(sut, {{3000, 0.26f}}, 12000);
+        const auto fadeSamples = timeChange == DSP::DelayTimeChange::Crossfade ? 8192 : 256;
+        EXPECT_NEAR(delayTimes[3000 + fadeSamples / 2], 2549.f, 1.f);
+        EXPECT_NEAR(delayTimes[3000 + fadeSamples], 2599.f, 1E-2f);
+    }
+}
+
+TEST(DigitalDelayTest, halfSampleRoundTrip)
+{
+    using Half = DSP::DelaySample<DSP::DelayStorage::Half>;
+    // every finite half, normal and subnormal
+    for (uint32_t bits = 0; bits < 0x10000; ++bits)
+    {
+        if ((bits & 0x7c00u) == 0x7c00u)
+        {
+            continue;
+        }
+        const auto value = Half::decode(static_cast<uint16_t>(bits));
+        ASSERT_EQ(Half::encode(value, 0), bits) << value;
+    }
+    EXPECT_EQ(Half::decode(0x3c00u), 1.f);
+    EXPECT_EQ(Half::decode(0xc000u), -2.f);
+    EXPECT_EQ(Half::decode(0x0001u), 0x1p-24f);
+    // to nearest even between 1 and the next half 1 + 2^-10, the largest half on overflow
+    EXPECT_EQ(Half::encode(1.f + 0x1p-11f, 0), 0x3c00u);
+    EXPECT_EQ(Half::encode(1.f + 0x1p-11f + 0x1p-20f, 0), 0x3c01u);
+    EXPECT_EQ(Half::encode(1.f + 0x1p-10f + 0x1p-11f, 0), 0x3c02u);
+    EXPECT_EQ(Half::encode(1e6f, 0), 0x7bffu);
+    EXPECT_EQ(Half::encode(-1e6f, 0), 0xfbffu);
+}
+
+TEST(DigitalDelayTest, int16SampleClipsAndDithers)
+{
+    using Int16 = DSP::DelaySample<DSP::DelayStorage::Int16>;
+    EXPECT_EQ(Int16::decode(Int16::encode(3.f, 0)), Int16::FullScale * 32767.f / 32768.f);
+    EXPECT_EQ(Int16::decode(Int16::encode(-3.f, 0)), -Int16::FullScale);
+    // the dither keeps the mean of a constant below a step
+    double sum{0};
+    for (uint32_t count = 0; count < 10000; ++count)
+    {
+        const auto value = Int16::decode(Int16::encode(Int16::Step * 0.3f, count));
+        EXPECT_LE(std::abs(value - Int16::Step * 0.3f), Int16::Step * 1.5f);
+        sum += value;
+    }
+    EXPECT_NEAR(sum / 10000, Int16::Step * 0.3f, Int16::Step * 0.05f);
+}
+
+namespace
+{
+// the noise of the storage against float storage for a sine of the given amplitude, in dB rms
+template <DSP::DelayStorage Storage>
+float storageNoise(const float amplitude)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::DigitalDelay<1000, DSP::DelayWrapping::Modulo, Storage> sut{sampleRate};
+    DSP::DigitalDelay<1000> reference{sampleRate};
+    std::vector<float> source(48000);
+    DSP::renderSine(source, sampleRate, 557.f);
+    for (auto& value : source)
+    {
+        value *= amplitude;
+    }
+    std::vector<float> result(source.size());
+    std::vector<float> expected(source.size());
+    sut.processBlock(source.data(), result.data(), source.size());
+    reference.processBlock(source.data(), expected.data(), source.size());
+    // after the delay of 250 msecs
+    double energy{0};
+    for (size_t i = source.size() / 2; i < source.size(); ++i)
+    {
+        energy += (result[i] - expected[i]) * static_cast<double>(result[i] - expected[i]);
+    }
+    return static_cast<float>(10 * std::log10(energy / static_cast<double>(source.size() / 2)));
+}
+}
+
+// the documented noise floors, measured after the interpolation: about -93 dBFS for Int16 at any level, about 78 dB
+// below the signal for Half
+TEST(DigitalDelayTest, storageNoiseFloor)
+{
+    for (const auto amplitude : {1.9f, 0.5f, 1e-3f})
+    {
+        const auto signal = 20 * std::log10(amplitude / std::numbers::sqrt2_v<float>);
+        EXPECT_LT(storageNoise<DSP::DelayStorage::Int16>(amplitude), -90.f) << amplitude;
+        EXPECT_LT(storageNoise<DSP::DelayStorage::Half>(amplitude), signal - 72.f) << amplitude;
+    }
+    // Half keeps the silence, Int16 dithers it
+    EXPECT_LT(storageNoise<DSP::DelayStorage::Half>(0.f), -300.f);
+
+    DSP::DigitalDelay<1000> floats{48000.f};
+    DSP::DigitalDelay<1000, DSP::DelayWrapping::Modulo, DSP::DelayStorage::Int16> int16s{48000.f};
+    DSP::DigitalDelay<1000, DSP::DelayWrapping::Modulo, DSP::DelayStorage::Half> halfs{48000.f};
+    EXPECT_EQ(int16s.memoryInBytes() * 2, floats.memoryInBytes());
+    EXPECT_EQ(halfs.memoryInBytes() * 2, floats.memoryInBytes());
+}
+
+// grown in between blocks like by a timer, the history is kept, so it sounds like a delay with the full buffer
+TEST(DigitalDelayTest, growingMatchesFullSize)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::GrowingDigitalDelay<10000> sut{sampleRate};
+    DSP::DigitalDelay<10000> reference{sampleRate};
+    EXPECT_EQ(sut.memoryInBytes(), DSP::DigitalDelay<500>(sampleRate).memoryInBytes());
+    sut.setModulationSpeed(2.f);
+    sut.setModulationDepth(30.f);
+    sut.setTime(0.3f);
+    reference.setModulationSpeed(2.f);
+    reference.setModulationDepth(30.f);
+    reference.setTime(0.3f);
+
+    constexpr size_t blockSize{256};
+    constexpr size_t firstGrowth{blockSize * 200};
+    constexpr size_t secondGrowth{blockSize * 400};
+    std::vector<float> source(48000 * 6);
+    DSP::renderSine(source, sampleRate, 330.f);
+    // what is older than the small buffer is gone when it grows, so the signal starts within it
+    std::fill_n(source.begin(), firstGrowth - 20000, 0.f);
+    std::vector<float> result(source.size());
+    std::vector<float> expected(source.size());
+    for (size_t index = 0; index + blockSize <= source.size(); index += blockSize)
+    {
+        if (index == firstGrowth || index == secondGrowth)
+        {
+            const auto seconds = index == firstGrowth ? 2.f : 4.5f;
+            sut.setTime(seconds);
+            reference.setTime(seconds);
+            EXPECT_TRUE(sut.grow());
+            EXPECT_FALSE(sut.grow()); // not taken yet
+        }
+        sut.processBlock(source.data() + index, result.data() + index, blockSize);
+        reference.processBlock(source.data() + index, expected.data() + index, blockSize);
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_NEAR(result[i], expected[i], 1E-6f) << i;
+    }
+    EXPECT_GT(sut.memoryInBytes(), static_cast<size_t>(4.5f * sampleRate) * sizeof(float));
+    EXPECT_LT(sut.memoryInBytes(), reference.memoryInBytes() / 2);
+    EXPECT_FALSE(sut.grow()); // frees the previous buffer only
+}
+
+TEST(DigitalDelayTest, growingKeepsTheTimeUntilGrown)
+{
+    constexpr float sampleRate{10000.f};
+    DSP::GrowingDigitalDelay<2000> sut{sampleRate};
+    sut.setModulationDepth(0.f);
+    sut.setTimeChange(DSP::DelayTimeChange::AdaptiveCrossfade);
+    sut.setTime(0.05f);
+    std::vector<float> silence(10000);
+    std::vector<float> out(silence.size());
+    sut.processBlock(silence.data(), out.data(), silence.size());
+
+    const auto memory = sut.memoryInBytes();
+    sut.setTime(1.5f);
+    std::vector<float> impulse(1000);
+    impulse[0] = 1.f;
+    sut.processBlock(impulse.data(), out.data(), impulse.size());
+    EXPECT_EQ(sut.memoryInBytes(), memory);
+    // still the delay of 500 samples (minus one, the b-spline spreads the impulse)
+    EXPECT_NEAR(out[498] + out[499] + out[500], 1.f, 1E-6f);
+
+    EXPECT_TRUE(sut.grow());
+    sut.processBlock(silence.data(), out.data(), 1);
+    EXPECT_EQ(sut.memoryInBytes(), (15000 + DSP::DelayTap::Headroom + 5) * sizeof(float));
+}
+
+TEST(DigitalDelayTest, growingSkipsAnAbandonedTime)
+{
+    constexpr float sampleRate{10000.f};
+    DSP::GrowingDigitalDelay<2000> sut{sampleRate};
+    const auto memory = sut.memoryInBytes();
+    sut.setTime(1.5f);
+    sut.setTime(0.2f); // fits, the longer time is not needed anymore
+    EXPECT_FALSE(sut.grow());
+    std::vector<float> block(128);
+    sut.processBlock(block.data(), block.data(), block.size());
+    EXPECT_EQ(sut.memoryInBytes(), memory);
+}
+
+TEST(DigitalDelayTest, growingOnAnotherThread)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::GrowingDigitalDelay<10000> sut{sampleRate};
+    std::atomic<bool> done{false};
+    std::thread timer(
+        [&]()
+        {
+            while (!done)
+            {
+                sut.grow();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+    std::vector<float> block(128, 0.5f);
+    for (size_t second = 1; second < 10; ++second)
+    {
+        sut.setTime(static_cast<float>(second));
+        for (size_t i = 0; i < 48000 / block.size(); ++i)
+        {
+            sut.processBlock(block.data(), block.data(), block.size());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    // the last growth is taken with the next block
+    while (sut.memoryInBytes() < static_cast<size_t>(9 * sampleRate) * sizeof(float))
+    {
+        sut.processBlock(block.data(), block.data(), block.size());
+        std::this_thread::yield();
+    }
+    done = true;
+    timer.join();
+    EXPECT_EQ(sut.memoryInBytes(), DSP::DigitalDelay<10000>(sampleRate).memoryInBytes());
+}
 }
@@ -0,0 +1,60 @@
+#include "FastMath.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <numbers>
+
+namespace DspTest
+{
+
+TEST(DspFastMathTest, tanRelativeError)
+{
+    // the cutoff range of the biquads: pi * frequency / sampleRate up to 0.49 * sampleRate
+    for (float fc = 1E-5f; fc <= 0.49f; fc *= 1.001f)
+    {
+        const auto x = std::numbers::pi_v<float> * fc;
+        const auto exact = std::tan(static_cast<double>(x));
+        EXPECT_NEAR(DSP::fastTan(x) / exact, 1., 1E-5) << "fc " << fc;
+        EXPECT_NEAR(DSP::fastTan(-x) / -exact, 1., 1E-5) << "fc " << fc;
+    }
+}
+
+TEST(DspFastMathTest, sinCycleAbsoluteError)
+{
+    for (float x = -100.f; x <= 100.f; x += 0.000713f)
+    {
+        const auto exact = std::sin(2. * std::numbers::pi * static_cast<double>(x));
+        EXPECT_NEAR(DSP::fastSinCycle(x), exact, 5E-7) << "x " << x;
+    }
+}
+
+TEST(DspFastMathTest, exp2RelativeError)
+{
+    for (float x = -100.f; x <= 100.f; x += 0.0137f)
+    {
+        EXPECT_NEAR(DSP::fastExp2(x) / std::exp2(static_cast<double>(x)), 1., 3E-7) << "x " << x;
+    }
+}
+
+TEST(DspFastMathTest, expRelativeError)
+{
+    // the poles of the four stage filter, exp(-2 pi cutoff / sampleRate)
+    for (float x = -8.f; x <= 8.f; x += 0.00113f)
+    {
+        EXPECT_NEAR(DSP::fastExp(x) / std::exp(static_cast<double>(x)), 1., 1E-6) << "x " << x;
+    }
+    for (float x = -86.f; x <= 86.f; x += 0.0113f)
+    {
+        EXPECT_NEAR(DSP::fastExp(x) / std::exp(static_cast<double>(x)), 1., 1E-5) << "x " << x;
+    }
+}
+
+TEST(DspFastMathTest, pow10RelativeError)
+{
+    for (float x = -4.f; x <= 4.f; x += 0.001f)
+    {
+        EXPECT_NEAR(DSP::fastPow10(x) / std::pow(10., static_cast<double>(x)), 1., 1E-6) << "x " << x;
+    }
+}
+}
@@ -6,6 +6,8 @@
 #include <array>
 #include <cmath>
 #include <random>
+#include <utility>
+#include <vector>
 
 namespace DspTest
 {
@@ -140,4 +142,236 @@ INSTANTIATE_TEST_SUITE_P(DSPFilter4StageTest, Filter4TheoreticalValues,
                                             testing::Values(100.0, 200.0, 400.0, 800.0, 1600.0, 3200.0),
                                             testing::Values(0.0, 0.20, 0.50)));
 
+
+namespace
+{
+std::vector<float> noise(size_t numSamples)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::vector<float> values(numSamples);
+    std::generate(values.begin(), values.end(), [&]() { return distribution(generator); });
+    return values;
+}
+
+template <size_t Mode>
+void expectModeMatchesMultiFilter(const std::vector<float>& source)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::FourStageMultiFilter<DSP::FourStageModeFactors[Mode]> reference(sampleRate);
+    DSP::FourStageMultiModeFilter sut(sampleRate, static_cast<DSP::FourStageMode>(Mode));
+    std::vector<float> expected(source.size());
+    std::vector<float> result(source.size());
+    reference.setCutoff(800.f);
+    reference.setResonance(0.3f);
+    sut.setCutoff(800.f);
+    sut.setResonance(0.3f);
+    for (size_t i = 0; i < source.size(); i += 100)
+    {
+        const auto n = std::min<size_t>(100, source.size() - i);
+        reference.processBlock(source.data() + i, expected.data() + i, n);
+        sut.processBlock(source.data() + i, result.data() + i, n);
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_EQ(result[i], expected[i]) << "mode " << Mode << " sample " << i;
+    }
+}
+}
+
+TEST(DSPFilter4StageTest, multiModeMatchesEachMultiFilter)
+{
+    const auto source = noise(1000);
+    [&]<size_t... Mode>(std::index_sequence<Mode...>)
+    {
+        (expectModeMatchesMultiFilter<Mode>(source), ...);
+    }(std::make_index_sequence<DSP::FourStageModeFactors.size()>{});
+}
+
+TEST(DSPFilter4StageTest, multiModeFadesToTheNewMode)
+{
+    constexpr float sampleRate{48000.f};
+    constexpr size_t switchAt{500};
+    constexpr size_t fadeSteps{300};
+    const auto source = noise(2000);
+    DSP::FourStageMultiModeFilter sut(sampleRate, DSP::FourStageMode::Lp24);
+    DSP::Lp24Smooth from(sampleRate);
+    DSP::Hp12Smooth to(sampleRate);
+    sut.setModeFadeSteps(fadeSteps);
+    std::vector<float> result(source.size());
+    std::vector<float> expectedFrom(source.size());
+    std::vector<float> expectedTo(source.size());
+    const auto process = [&](size_t start, size_t end)
+    {
+        for (size_t i = start; i < end; i += 64)
+        {
+            const auto n = std::min<size_t>(64, end - i);
+            sut.processBlock(source.data() + i, result.data() + i, n);
+            from.processBlock(source.data() + i, expectedFrom.data() + i, n);
+            to.processBlock(source.data() + i, expectedTo.data() + i, n);
+        }
+    };
+
+    process(0, switchAt);
+    sut.setMode(DSP::FourStageMode::Hp12);
+    EXPECT_EQ(sut.mode(), DSP::FourStageMode::Hp12);
+    process(switchAt, source.size());
+
+    // the stages are shared, so the output is the linear blend of both modes while fading
+    for (size_t i = 0; i < switchAt; ++i)
+    {
+        ASSERT_EQ(result[i], expectedFrom[i]) << i;
+    }
+    for (size_t i = switchAt; i < switchAt + fadeSteps; ++i)
+    {
+        const auto factor = static_cast<float>(i - switchAt + 1) / fadeSteps;
+        ASSERT_NEAR(result[i], (1 - factor) * expectedFrom[i] + factor * expectedTo[i], 1E-4f) << i;
+    }
+    for (size_t i = switchAt + fadeSteps; i < source.size(); ++i)
+    {
+        ASSERT_EQ(result[i], expectedTo[i]) << i;
+    }
+}
+class ZdfFilterTheoreticalValues : public testing::TestWithParam<std::tuple<double, double>>
+{
+};
+
+// the lowpass of the zero delay feedback filter is in tune with the analog one up to high resonance, where the
+// feedback delayed by a sample of MultiModeFourPoleMixerModule detunes it
+TEST_P(ZdfFilterTheoreticalValues, lowpassMagnitudes)
+{
+    const double cf = std::get<0>(GetParam());
+    const double reso = std::get<1>(GetParam());
+    constexpr double sampleRate{48000};
+    for (const auto ratio : {0.5, 1.0, 2.0})
+    {
+        const auto hz = cf * ratio;
+        DSP::ZdfFourPoleMixerModule<2> sut(sampleRate);
+        sut.setCutoff(cf);
+        sut.setResonance(reso);
+        std::vector<float> wave(24000);
+        DSP::renderSine(wave, sampleRate, hz);
+        sut.processBlock(wave.data(), wave.size());
+        const auto maxValue = std::abs(*std::max_element(wave.begin() + wave.size() / 2, wave.end(),
+                                                         [](float a, float b) { return std::abs(a) < std::abs(b); }));
+        const auto db = std::log10(maxValue) * 20.0;
+
+        MultifilterTheoretical ft{0, 0, 0, 0, 1};
+        const auto expectedDb = std::log10(ft.magnitude(ratio, reso * 4.0)) * 20.0;
+        EXPECT_NEAR(db, expectedDb, 0.6) << "hz:" << hz << " \tcutoff:" << cf << "\treso:" << reso;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(DSPFilter4StageTest, ZdfFilterTheoreticalValues,
+                         ::testing::Combine(testing::Values(200.0, 1000.0, 4000.0),
+                                            testing::Values(0.0, 0.5, 0.9)));
+
+TEST(DSPFilter4StageTest, zdfBlockSizesDontMatter)
+{
+    const auto source = noise(1000);
+    DSP::ZdfFourPoleMixerModule<4> oneBlock(48000.f);
+    DSP::ZdfFourPoleMixerModule<4> manyBlocks(48000.f);
+    for (auto* sut : {&oneBlock, &manyBlocks})
+    {
+        sut->setCutoff(3000.f);
+        sut->setResonance(0.7f);
+        sut->setFactors(DSP::MultiModeBp12);
+    }
+    std::vector<float> expected(source.size());
+    std::vector<float> result(source.size());
+    oneBlock.processBlock(source.data(), expected.data(), source.size());
+    for (size_t i = 0; i < source.size(); i += 37)
+    {
+        manyBlocks.processBlock(source.data() + i, result.data() + i, std::min<size_t>(37, source.size() - i));
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_EQ(result[i], expected[i]) << i;
+    }
+}
+namespace
+{
+// an lfo sweep between 200 Hz and 5 kHz
+std::vector<float> cutoffSweep(size_t numSamples)
+{
+    std::vector<float> cutoff(numSamples);
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        cutoff[i] = 2600.f + 2400.f * std::sin(2.f * static_cast<float>(M_PI) * 3.f * static_cast<float>(i) / 48000.f);
+    }
+    return cutoff;
+}
+
+// the cutoff buffer against a setCutoff call before every single sample
+template <typename Filter>
+void expectModulationMatchesSetCutoffPerSample(Filter& sut, Filter& reference, const float tolerance)
+{
+    const auto source = noise(2000);
+    const auto cutoff = cutoffSweep(source.size());
+    std::vector<float> expected(source.size());
+    std::vector<float> result(source.size());
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        reference.setCutoff(cutoff[i]);
+        reference.processBlock(source.data() + i, expected.data() + i, 1);
+    }
+    for (size_t i = 0; i < source.size(); i += 100)
+    {
+        sut.processBlock(source.data() + i, cutoff.data() + i, result.data() + i, 100);
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_NEAR(result[i], expected[i], tolerance) << i;
+    }
+}
+}
+
+TEST(DSPFilter4StageTest, cutoffBufferModulatesEverySample)
+{
+    DSP::Lp24Smooth sut(48000.f);
+    DSP::Lp24Smooth reference(48000.f);
+    reference.setSmoothingSteps(0);
+    sut.setResonance(0.5f);
+    reference.setResonance(0.5f);
+    expectModulationMatchesSetCutoffPerSample(sut, reference, 1E-4f);
+}
+
+TEST(DSPFilter4StageTest, cutoffBufferModulatesEveryMode)
+{
+    for (const auto mode : {DSP::FourStageMode::Lp12, DSP::FourStageMode::Bp12, DSP::FourStageMode::Notch12Lp6})
+    {
+        DSP::FourStageMultiModeFilter sut(48000.f, mode);
+        DSP::FourStageMultiModeFilter reference(48000.f, mode);
+        reference.setSmoothingSteps(0);
+        expectModulationMatchesSetCutoffPerSample(sut, reference, 1E-4f);
+    }
+}
+
+TEST(DSPFilter4StageTest, zdfCutoffBufferModulatesEverySample)
+{
+    DSP::ZdfFourPoleMixerModule<2> sut(48000.f);
+    DSP::ZdfFourPoleMixerModule<2> reference(48000.f);
+    sut.setResonance(0.8f);
+    reference.setResonance(0.8f);
+    expectModulationMatchesSetCutoffPerSample(sut, reference, 1E-4f);
+}
+
+TEST(DSPFilter4StageTest, lastModulatedCutoffStays)
+{
+    const auto source = noise(512);
+    const std::vector<float> cutoff(256, 1500.f);
+    DSP::Lp24Smooth sut(48000.f);
+    DSP::Lp24Smooth reference(48000.f);
+    reference.setSmoothingSteps(0);
+    reference.setCutoff(1500.f);
+    std::vector<float> expected(source.size());
+    std::vector<float> result(source.size());
+    sut.processBlock(source.data(), cutoff.data(), result.data(), 256);
+    sut.processBlock(source.data() + 256, result.data() + 256, 256);
+    reference.processBlock(source.data(), expected.data(), source.size());
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_NEAR(result[i], expected[i], 1E-5f) << i;
+    }
+}
 }
@@ -0,0 +1,125 @@
+#include "LockFreeSlot.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace DspTest
+{
+
+TEST(DspLockFreeSlotTest, pullReturnsOnlyNewValues)
+{
+    DSP::LockFreeSlot<int> sut;
+    int value{-1};
+    EXPECT_FALSE(sut.pull(value));
+    EXPECT_EQ(value, -1);
+
+    sut.push(1);
+    sut.push(2);
+    EXPECT_TRUE(sut.pull(value));
+    EXPECT_EQ(value, 2); // the latest one wins
+    EXPECT_FALSE(sut.pull(value));
+
+    sut.push(3);
+    EXPECT_TRUE(sut.pull(value));
+    EXPECT_EQ(value, 3);
+}
+
+TEST(DspLockFreeSlotTest, readerNeverSeesTornValues)
+{
+    using Values = std::array<float, 5>;
+    constexpr int numPushes{200000};
+    DSP::LockFreeSlot<Values> sut;
+
+    std::thread writer(
+        [&sut]()
+        {
+            for (int i = 1; i <= numPushes; ++i)
+            {
+                const auto v = static_cast<float>(i);
+                sut.push({v, v, v, v, v});
+            }
+        });
+
+    Values values{};
+    float last{0};
+    while (last < static_cast<float>(numPushes))
+    {
+        if (sut.pull(values))
+        {
+            for (const auto v : values)
+            {
+                ASSERT_EQ(v, values[0]);
+            }
+            ASSERT_GT(values[0], last);
+            last = values[0];
+        }
+    }
+    writer.join();
+}
+
+TEST(DspLockFreeHandoverTest, objectGoesToTheReaderAndBack)
+{
+    DSP::LockFreeHandover<std::vector<int>> sut;
+    EXPECT_EQ(sut.take(), nullptr);
+    EXPECT_TRUE(sut.collect());
+
+    sut.offer(std::make_unique<std::vector<int>>(3, 7));
+    EXPECT_FALSE(sut.collect()); // still offered
+    auto* offered = sut.take();
+    ASSERT_NE(offered, nullptr);
+    std::vector<int> current(1, 1);
+    std::swap(current, *offered);
+    sut.giveBack();
+    EXPECT_EQ(sut.take(), nullptr);
+    EXPECT_EQ(current, std::vector<int>(3, 7));
+    EXPECT_TRUE(sut.collect()); // frees the old one
+    EXPECT_TRUE(sut.collect());
+}
+
+TEST(DspLockFreeHandoverTest, readerGetsEveryObjectComplete)
+{
+    constexpr int numObjects{2000};
+    DSP::LockFreeHandover<std::vector<int>> sut;
+
+    std::thread writer(
+        [&sut]()
+        {
+            for (int i = 1; i <= numObjects;)
+            {
+                if (sut.collect())
+                {
+                    sut.offer(std::make_unique<std::vector<int>>(static_cast<size_t>(i), i));
+                    ++i;
+                }
+                std::this_thread::yield();
+            }
+            while (!sut.collect())
+            {
+                std::this_thread::yield();
+            }
+        });
+
+    std::vector<int> current;
+    int last{0};
+    while (last < numObjects)
+    {
+        if (auto* offered = sut.take())
+        {
+            std::swap(current, *offered);
+            sut.giveBack();
+            ASSERT_EQ(current.size(), static_cast<size_t>(last + 1));
+            for (const auto value : current)
+            {
+                ASSERT_EQ(value, last + 1);
+            }
+            last = current[0];
+        }
+        std::this_thread::yield();
+    }
+    writer.join();
+}
+}
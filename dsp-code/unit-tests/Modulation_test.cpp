@@ -134,4 +134,25 @@ TEST(ModulationTest, amplitudeAdjust)
     }
     EXPECT_NEAR(sut.currentMagnitude(), 0.2, 0.01);
 }
+
+TEST(ModulationTest, slowSineBlockMatchesTick)
+{
+    DSP::SlowSineLfo<float> ticked(48000.f);
+    DSP::SlowSineLfo<float> blocked(48000.f);
+    for (auto* lfo : {&ticked, &blocked})
+    {
+        lfo->reset(3.7f, 20.f);
+        lfo->changeAmplitude(50.f);
+    }
+    std::array<float, 1000> block{};
+    for (size_t round = 0; round < 48; ++round)
+    {
+        blocked.processBlock(block.data(), block.size());
+        for (const auto value : block)
+        {
+            ASSERT_NEAR(value, ticked.tickSine(), 50.f * 1E-6f);
+        }
+        EXPECT_EQ(blocked.lastSine(), block.back());
+    }
+}
 }
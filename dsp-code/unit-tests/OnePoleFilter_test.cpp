@@ -4,7 +4,11 @@
 #include "AudioProcessing.h"
 #include "OnePoleFilter.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <random>
+#include <vector>
 namespace DspTest
 {
 class OnePoleFilterTest : public testing::TestWithParam<std::tuple<double, double>>
@@ -61,4 +65,122 @@ TEST(OnePoleFilterTest, testAdaption)
     lp.processBlock(source.data(), 128);
     EXPECT_FLOAT_EQ(source[0], 0);
 }
+
+TEST(OnePoleFilterTest, scanMatchesSerial)
+{
+    constexpr auto sampleRate{48000.0f};
+    std::minstd_rand generator(7);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::vector<float> source(5000);
+    std::generate(source.begin(), source.end(), [&]() { return distribution(generator); });
+
+    for (const auto cutoff : {20.f, 440.f, 5000.f, 20000.f, 24000.f})
+    {
+        DSP::OnePoleFilter serial(sampleRate, cutoff);
+        DSP::OnePoleFilterOptimized sut(sampleRate, cutoff);
+        std::vector<float> expected(source.size());
+        std::vector<float> result(source.size());
+        serial.processBlock(source.data(), expected.data(), source.size());
+        // block sizes with and without a scalar tail
+        size_t blockSize = 1;
+        for (size_t offset = 0; offset < source.size(); offset += blockSize, blockSize = blockSize % 67 + 5)
+        {
+            const auto numSamples = std::min(blockSize, source.size() - offset);
+            sut.processBlock(source.data() + offset, result.data() + offset, numSamples);
+        }
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            ASSERT_NEAR(result[i], expected[i], 2E-6f) << "cutoff " << cutoff << " sample " << i;
+        }
+    }
+}
+
+TEST(OnePoleFilterTest, bankMatchesSingleFilters)
+{
+    constexpr size_t NumChannels{11}; // one full group of 8 lanes and a partial one
+    constexpr auto sampleRate{48000.0f};
+    DSP::OnePoleBank<NumChannels> sut(sampleRate);
+    std::array<std::vector<float>, NumChannels> wave;
+    std::array<std::vector<float>, NumChannels> expected;
+    std::array<const float*, NumChannels> in{};
+    std::array<float*, NumChannels> out{};
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        const auto cutoff = 200.f * static_cast<float>(c + 1);
+        const auto tap = static_cast<DSP::OnePoleTap>(c % 3);
+        sut.setCutoff(c, cutoff);
+        sut.setTap(c, tap);
+        wave[c].resize(1000);
+        DSP::renderSine(wave[c], sampleRate, 100.f * static_cast<float>(c + 1));
+
+        DSP::OnePoleFilterOptimized first(sampleRate, cutoff);
+        DSP::OnePoleFilterOptimized second(sampleRate, cutoff);
+        expected[c].resize(wave[c].size());
+        for (size_t i = 0; i < wave[c].size(); ++i)
+        {
+            const auto lowPass = first.next(wave[c][i]);
+            switch (tap)
+            {
+                case DSP::OnePoleTap::LowPass:
+                    expected[c][i] = lowPass;
+                    break;
+                case DSP::OnePoleTap::HighPass:
+                    expected[c][i] = wave[c][i] - lowPass;
+                    break;
+                case DSP::OnePoleTap::BandPass:
+                    expected[c][i] = second.next(lowPass) - lowPass;
+                    break;
+            }
+        }
+        in[c] = wave[c].data();
+        out[c] = wave[c].data(); // in place
+    }
+    sut.processBlock(in.data(), out.data(), 600);
+    std::transform(in.begin(), in.end(), in.begin(), [](const float* p) { return p + 600; });
+    std::transform(out.begin(), out.end(), out.begin(), [](float* p) { return p + 600; });
+    sut.processBlock(in.data(), out.data(), 400);
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        for (size_t i = 0; i < wave[c].size(); ++i)
+        {
+            ASSERT_NEAR(wave[c][i], expected[c][i], 1E-6f) << "channel " << c << " sample " << i;
+        }
+    }
+}
+
+TEST(OnePoleFilterTest, bankInterleavedMatchesPlanar)
+{
+    constexpr size_t NumChannels{6};
+    constexpr size_t numFrames{300};
+    DSP::OnePoleBank<NumChannels> planar(48000.f);
+    DSP::OnePoleBank<NumChannels> interleaved(48000.f);
+    for (auto* bank : {&planar, &interleaved})
+    {
+        bank->setCutoff(1000.f);
+        bank->setCutoff(3, 50.f);
+        bank->setTap(4, DSP::OnePoleTap::BandPass);
+    }
+    std::array<std::vector<float>, NumChannels> channels;
+    std::array<float*, NumChannels> pointers{};
+    std::vector<float> frames(numFrames * NumChannels);
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        channels[c].resize(numFrames);
+        DSP::renderSine(channels[c], 48000.f, 300.f * static_cast<float>(c + 1));
+        pointers[c] = channels[c].data();
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            frames[i * NumChannels + c] = channels[c][i];
+        }
+    }
+    planar.processBlock(pointers.data(), pointers.data(), numFrames);
+    interleaved.processBlockInterleaved(frames.data(), frames.data(), numFrames);
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            ASSERT_EQ(frames[i * NumChannels + c], channels[c][i]) << "channel " << c << " frame " << i;
+        }
+    }
+}
 }
@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+
+#include "Oversampling.h"
+
+#include <cmath>
+#include <vector>
+
+namespace DspTest
+{
+
+namespace
+{
+// amplitude of the frequency in the signal from the index on, hann windowed so a strong neighbour doesn't leak in
+double goertzel(const std::vector<float>& signal, const size_t from, const double hz, const double sampleRate)
+{
+    const auto coefficient = 2.0 * std::cos(2.0 * M_PI * hz / sampleRate);
+    const auto length = static_cast<double>(signal.size() - from);
+    double s1{0};
+    double s2{0};
+    for (size_t i = from; i < signal.size(); ++i)
+    {
+        const auto window = 1.0 - std::cos(2.0 * M_PI * static_cast<double>(i - from) / length);
+        const auto s = signal[i] * window + coefficient * s1 - s2;
+        s2 = s1;
+        s1 = s;
+    }
+    return std::sqrt(s1 * s1 + s2 * s2 - coefficient * s1 * s2) * 2.0 / length;
+}
+
+std::vector<float> sine(const size_t numSamples, const double hz, const double sampleRate)
+{
+    std::vector<float> values(numSamples);
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        values[i] = static_cast<float>(std::sin(2.0 * M_PI * hz * static_cast<double>(i) / sampleRate));
+    }
+    return values;
+}
+
+double toDb(const double value)
+{
+    return 20.0 * std::log10(value);
+}
+}
+
+template <size_t Factor>
+void expectAudioBandPassesAndImagesAreRejected()
+{
+    constexpr double sampleRate{48000};
+    constexpr size_t blockSize{DSP::Oversampler<Factor>::MaxBlockSize};
+    for (const auto hz : {100.0, 1000.0, 10000.0, 20000.0, 21500.0})
+    {
+        DSP::Oversampler<Factor> sut;
+        const auto in = sine(8192, hz, sampleRate);
+        std::vector<float> high(in.size() * Factor);
+        std::vector<float> out(in.size());
+        for (size_t i = 0; i < in.size(); i += blockSize)
+        {
+            sut.upsample(in.data() + i, high.data() + i * Factor, blockSize);
+            sut.downsample(high.data() + i * Factor, out.data() + i, blockSize);
+        }
+        EXPECT_NEAR(toDb(goertzel(high, 1024, hz, sampleRate * Factor)), 0.0, 0.05) << hz;
+        EXPECT_LT(toDb(goertzel(high, 1024, sampleRate - hz, sampleRate * Factor)), -75.0) << hz;
+        if constexpr (Factor == 4)
+        {
+            // the image of the second stage
+            EXPECT_LT(toDb(goertzel(high, 1024, sampleRate * 2 - hz, sampleRate * Factor)), -75.0) << hz;
+        }
+        EXPECT_NEAR(toDb(goertzel(out, 512, hz, sampleRate)), 0.0, 0.05) << hz;
+    }
+}
+
+TEST(DspOversamplingTest, twoTimesPassesTheAudioBand)
+{
+    expectAudioBandPassesAndImagesAreRejected<2>();
+}
+
+TEST(DspOversamplingTest, fourTimesPassesTheAudioBand)
+{
+    expectAudioBandPassesAndImagesAreRejected<4>();
+}
+
+TEST(DspOversamplingTest, downsamplingRejectsAliases)
+{
+    constexpr double sampleRate{48000};
+    for (const auto hz : {27000.0, 35000.0, 45000.0})
+    {
+        DSP::Downsampler2x<DSP::Oversampler<2>::FirstStageCoefficients> sut(DSP::Oversampler<2>::FirstStageTransition);
+        const auto in = sine(16384, hz, sampleRate * 2);
+        std::vector<float> out(in.size() / 2);
+        sut.processBlock(in.data(), out.data(), out.size());
+        // folds back to 2 * sampleRate - hz
+        EXPECT_LT(toDb(goertzel(out, 512, sampleRate - (hz - sampleRate), sampleRate)), -75.0) << hz;
+    }
+}
+}
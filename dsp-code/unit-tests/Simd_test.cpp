@@ -0,0 +1,95 @@
+#include "Simd.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <numeric>
+
+namespace DspTest
+{
+
+template <typename T>
+class SimdFloatTest : public testing::Test
+{
+};
+
+using LaneCounts = testing::Types<DSP::SimdFloat<4>, DSP::SimdFloat<8>, DSP::SimdFloat<16>>;
+TYPED_TEST_SUITE(SimdFloatTest, LaneCounts);
+
+TYPED_TEST(SimdFloatTest, arithmeticPerLane)
+{
+    constexpr auto Lanes = TypeParam::size();
+    std::array<float, Lanes> a{};
+    std::array<float, Lanes> b{};
+    std::iota(a.begin(), a.end(), 1.f);
+    std::iota(b.begin(), b.end(), -4.f);
+    const auto va = TypeParam::load(a.data());
+    const auto vb = TypeParam::load(b.data());
+    std::array<float, Lanes> result{};
+    (va * vb + TypeParam::broadcast(0.5f) - va).store(result.data());
+    for (size_t i = 0; i < Lanes; ++i)
+    {
+        EXPECT_FLOAT_EQ(result[i], a[i] * b[i] + 0.5f - a[i]);
+        EXPECT_FLOAT_EQ((-va)[i], -a[i]);
+        EXPECT_FLOAT_EQ((vb / va)[i], b[i] / a[i]);
+    }
+    EXPECT_FLOAT_EQ(va.sum(), std::accumulate(a.begin(), a.end(), 0.f));
+}
+
+TYPED_TEST(SimdFloatTest, unalignedLoadAndStore)
+{
+    constexpr auto Lanes = TypeParam::size();
+    std::array<float, Lanes + 1> source{};
+    std::iota(source.begin(), source.end(), 0.f);
+    auto v = TypeParam::load(source.data() + 1);
+    v.set(0, 42.f);
+    std::array<float, Lanes + 1> target{};
+    v.store(target.data() + 1);
+    EXPECT_EQ(target[0], 0.f);
+    EXPECT_EQ(target[1], 42.f);
+    for (size_t i = 2; i <= Lanes; ++i)
+    {
+        EXPECT_EQ(target[i], source[i]);
+    }
+}
+
+TYPED_TEST(SimdFloatTest, shiftUpMovesLanesByOne)
+{
+    constexpr auto Lanes = TypeParam::size();
+    std::array<float, Lanes> source{};
+    std::iota(source.begin(), source.end(), 1.f);
+    const auto shifted = TypeParam::load(source.data()).shiftUp(-1.f);
+    EXPECT_EQ(shifted[0], -1.f);
+    for (size_t i = 1; i < Lanes; ++i)
+    {
+        EXPECT_EQ(shifted[i], source[i - 1]);
+    }
+}
+
+TYPED_TEST(SimdFloatTest, shiftUpByCountFillsZeros)
+{
+    constexpr auto Lanes = TypeParam::size();
+    std::array<float, Lanes> source{};
+    std::iota(source.begin(), source.end(), 1.f);
+    const auto shifted = TypeParam::load(source.data()).template shiftUp<3>();
+    for (size_t i = 0; i < Lanes; ++i)
+    {
+        EXPECT_EQ(shifted[i], i < 3 ? 0.f : source[i - 3]);
+    }
+}
+
+TYPED_TEST(SimdFloatTest, swapLanesByMask)
+{
+    constexpr auto Lanes = TypeParam::size();
+    std::array<float, Lanes> source{};
+    std::iota(source.begin(), source.end(), 1.f);
+    const auto value = TypeParam::load(source.data());
+    const auto neighbours = value.template swapLanes<1>();
+    const auto pairs = value.template swapLanes<2>();
+    for (size_t i = 0; i < Lanes; ++i)
+    {
+        EXPECT_EQ(neighbours[i], source[i ^ 1]);
+        EXPECT_EQ(pairs[i], source[i ^ 2]);
+    }
+}
+}
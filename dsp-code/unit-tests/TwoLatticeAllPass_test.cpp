@@ -1,4 +1,5 @@
 
+#include "AudioProcessing.h"
 #include "TwoLatticeAllPass.h"
 
 #include "gtest/gtest.h"
@@ -7,6 +8,7 @@
 #include <array>
 #include <cmath>
 #include <numbers>
+#include <vector>
 
 namespace DspTest
 {
@@ -86,4 +88,48 @@ TEST(TwoLatticeAllPassTest, withLowPass)
     EXPECT_LT(target[280], -0.02);
     EXPECT_LT(target[281], -0.02);
 }
+
+// segments around the end of the buffer, sizes shorter than a segment and changes of the size in between
+TEST(TwoLatticeAllPassTest, blockMatchesPerSample)
+{
+    constexpr float sampleRate{48000.f};
+    DSP::TwoLatticeAllPass<1000> sut{sampleRate};
+    DSP::TwoLatticeAllPassPerSample<1000> reference{sampleRate};
+    sut.setFeedback(0.7f);
+    reference.setFeedback(0.7f);
+    sut.setLowpassCutoff(5000.f);
+    reference.setLowpassCutoff(5000.f);
+
+    std::vector<float> source(48000);
+    DSP::renderSine(source, sampleRate, 440.f);
+    source[0] = 1.f;
+    std::vector<float> result(source.size());
+    std::vector<float> expected(source.size());
+    constexpr std::array<size_t, 5> blockSizes{1, 13, 64, 128, 777};
+    constexpr std::array<size_t, 4> sizes{1000, 60, 523, 51};
+    for (size_t index = 0, round = 0; index < source.size(); ++round)
+    {
+        if (round % 20 == 0)
+        {
+            sut.setSize(sizes[round / 20 % sizes.size()]);
+            reference.setSize(sizes[round / 20 % sizes.size()]);
+        }
+        const auto blockSize = std::min(blockSizes[round % blockSizes.size()], source.size() - index);
+        sut.processBlock(source.data() + index, result.data() + index, blockSize);
+        reference.processBlock(source.data() + index, expected.data() + index, blockSize);
+        index += blockSize;
+    }
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_EQ(result[i], expected[i]) << i;
+    }
+
+    std::copy(source.begin(), source.end(), result.begin());
+    sut.processBlockInplace(result.data(), result.size());
+    reference.processBlock(source.data(), expected.data(), expected.size());
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        ASSERT_EQ(result[i], expected[i]) << i;
+    }
+}
 }
@@ -0,0 +1,194 @@
+#include "BiquadEqualizer.h"
+#include "DspPerformance.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace DspPerformanceTest
+{
+
+TEST(BiquadEqualizerPerformanceTest, compareMagnitudeCurveWithResponse)
+{
+    constexpr size_t MaxOrder{4};
+    constexpr size_t NumPoints{1024};
+    constexpr float sampleRate{48000.f};
+
+    // a curve as drawn by the ui, a new gain for every frame so nothing is cached
+    class SUTBase
+    {
+      public:
+        SUTBase()
+        {
+            for (size_t i = 0; i < NumPoints; ++i)
+            {
+                m_frequencies[i] = 20.f * std::pow(1000.f, static_cast<float>(i) / NumPoints);
+            }
+            sut.setBass(MaxOrder, 100.f, 0.707f);
+            sut.setTreble(MaxOrder, 8000.f, 0.707f);
+        }
+
+        void process()
+        {
+            m_gain = m_gain > 12.f ? -12.f : m_gain + 0.1f;
+            sut.setParametric(1000.f, 0.707f, m_gain);
+            for (size_t i = 0; i < NumPoints; ++i)
+            {
+                m_db[i] = sut.getMagnitude(m_frequencies[i]);
+            }
+            EXPECT_LT(m_db[0], 0.f);
+        }
+
+      protected:
+        DSP::BiquadEqualizer<MaxOrder> sut{sampleRate};
+        std::array<float, NumPoints> m_frequencies{};
+        std::array<float, NumPoints> m_db{};
+        float m_gain{0.f};
+    };
+
+    class SUTOptimized : public SUTBase
+    {
+      public:
+        void process()
+        {
+            m_gain = m_gain > 12.f ? -12.f : m_gain + 0.1f;
+            sut.setParametric(1000.f, 0.707f, m_gain);
+            sut.magnitudeResponse(m_frequencies, m_db);
+            EXPECT_LT(m_db[0], 0.f);
+        }
+    };
+
+    const auto seconds = .5f;
+    SUTBase sutBase;
+    SUTOptimized sutOptimized;
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(NumPoints * iterationsForOneRound, seconds, sampleRate);
+}
+
+TEST(BiquadEqualizerPerformanceTest, compareStaticWithAutomatedSmooth)
+{
+    constexpr size_t MaxOrder{4};
+    constexpr size_t blockSize{128};
+    constexpr float sampleRate{48000.f};
+
+    class SUTBase
+    {
+      public:
+        SUTBase()
+        {
+            m_left[0] = 1.f;
+            sut.setBass(MaxOrder, 100.f, 0.707f);
+            sut.setParametric(1000.f, 0.707f, 6.f);
+            sut.setTreble(MaxOrder, 8000.f, 0.707f);
+        }
+
+        void process()
+        {
+            sut.processBlock(m_left.data(), m_right.data(), m_left.data(), m_right.data(), blockSize);
+        }
+
+      protected:
+        DSP::BiquadEqualizer<MaxOrder> sut{sampleRate};
+        std::array<float, blockSize> m_left{};
+        std::array<float, blockSize> m_right{};
+    };
+
+    // the gain of the peak filter is automated, a new value for every block keeps it fading all the time
+    class SUTOptimized : public SUTBase
+    {
+      public:
+        SUTOptimized()
+        {
+            smooth.setBassOrder(MaxOrder);
+            smooth.setTrebleOrder(MaxOrder);
+        }
+
+        void process()
+        {
+            m_gain = m_gain > 12.f ? -12.f : m_gain + 0.01f;
+            smooth.setParametricGain(m_gain);
+            smooth.processBlock(m_left.data(), m_right.data(), m_left.data(), m_right.data(), blockSize);
+        }
+
+      protected:
+        DSP::BiquadEqualizerSmooth<MaxOrder> smooth{sampleRate};
+        float m_gain{1.f};
+    };
+
+    const auto seconds = .5f;
+    SUTBase sutBase;
+    SUTOptimized sutOptimized;
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(blockSize * iterationsForOneRound, seconds, sampleRate);
+}
+
+namespace
+{
+// nanoseconds per stereo sample of the serial and the fused kernel, all filters active
+template <size_t MaxOrder>
+void compareFusedWithSerial(const size_t blockSize)
+{
+    constexpr size_t numSamples{1 << 18};
+    constexpr float sampleRate{48000.f};
+    DSP::BiquadEqualizer<MaxOrder> eq(sampleRate);
+    eq.setBass(MaxOrder, 100.f, 0.707f);
+    eq.setParametric(1000.f, 0.707f, 6.f);
+    eq.setTreble(MaxOrder, 8000.f, 0.707f);
+    std::vector<float> source(blockSize, 0.f);
+    std::minstd_rand generator(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::generate(source.begin(), source.end(), [&]() { return distribution(generator); });
+    std::vector<float> left(blockSize, 0.f);
+    std::vector<float> right(blockSize, 0.f);
+
+    const auto measure = [&](const auto& process)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t done = 0; done < numSamples; done += blockSize)
+        {
+            process();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()) /
+               static_cast<double>(numSamples);
+    };
+    const auto serial = measure(
+        [&]() { eq.processBlockSerial(source.data(), source.data(), left.data(), right.data(), blockSize); });
+    const auto fused =
+        measure([&]() { eq.processBlock(source.data(), source.data(), left.data(), right.data(), blockSize); });
+    EXPECT_TRUE(std::isfinite(left[0]));
+    std::cout << "order " << MaxOrder << " block " << std::setw(4) << blockSize << ": serial " << std::setw(6)
+              << serial << " ns fused " << std::setw(6) << fused << " ns r: " << std::setw(3)
+              << static_cast<int>(serial * 100 / fused) << "%" << std::endl;
+}
+}
+
+TEST(BiquadEqualizerPerformanceTest, compareFusedWithSerial)
+{
+    for (size_t blockSize = 16; blockSize <= 4096; blockSize *= 2)
+    {
+        [blockSize]<size_t... Order>(std::index_sequence<Order...>)
+        { (compareFusedWithSerial<Order + 1>(blockSize), ...); }(std::make_index_sequence<8>{});
+    }
+}
+}
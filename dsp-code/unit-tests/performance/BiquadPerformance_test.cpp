@@ -137,4 +137,330 @@ TEST(BiquadPerformanceTest, compareOlder)
     }
     std::cout << "Local speed factor: " << sutOptimized.samplesProcessed() / 48000.f / oneBurnInSeconds << std::endl;
 }
+
+TEST(BiquadPerformanceTest, compareBankWithStereoInstances)
+{
+    constexpr size_t iterationsPerProcess{10};
+    constexpr size_t NumChannels{32};
+    constexpr size_t BlockSize{256};
+    constexpr float sampleRate{48000.f};
+
+    // the current way: one BiquadStereo per channel pair
+    class SUTBase
+    {
+      public:
+        SUTBase()
+        {
+            for (size_t i = 0; i < sut.size(); ++i)
+            {
+                sut[i].computeCoefficients(sampleRate, 100.f + 100.f * static_cast<float>(i), 0.707, 3);
+            }
+        }
+
+        void process()
+        {
+            for (size_t i = 0; i < iterationsPerProcess; ++i)
+            {
+                for (size_t c = 0; c < NumChannels; c += 2)
+                {
+                    m_data[c][0] = 1.f;
+                    m_data[c + 1][0] = 1.f;
+                    sut[c / 2].processBlock(m_data[c].data(), m_data[c + 1].data(), m_data[c].data(),
+                                            m_data[c + 1].data(), BlockSize);
+                }
+                EXPECT_NE(m_data[0][0], 0);
+            }
+            m_samplesProcessed += iterationsPerProcess * BlockSize;
+        }
+
+        size_t samplesProcessed() const
+        {
+            return m_samplesProcessed;
+        }
+
+      private:
+        std::array<DSP::BiquadStereo<DSP::BiquadFilterType::Peak>, NumChannels / 2> sut{};
+        std::array<std::array<float, BlockSize>, NumChannels> m_data{};
+        size_t m_samplesProcessed{0};
+    };
+
+    class SUTOptimized
+    {
+      public:
+        SUTOptimized()
+        {
+            for (size_t c = 0; c < NumChannels; ++c)
+            {
+                sut.computeCoefficients(c, sampleRate, 100.f + 100.f * static_cast<float>(c / 2), 0.707, 3);
+                m_pointers[c] = m_data[c].data();
+            }
+        }
+
+        void process()
+        {
+            for (size_t i = 0; i < iterationsPerProcess; ++i)
+            {
+                for (auto& channel : m_data)
+                {
+                    channel[0] = 1.f;
+                }
+                sut.processBlock(m_pointers.data(), m_pointers.data(), BlockSize);
+                EXPECT_NE(m_data[0][0], 0);
+            }
+            m_samplesProcessed += iterationsPerProcess * BlockSize;
+        }
+
+        size_t samplesProcessed() const
+        {
+            return m_samplesProcessed;
+        }
+
+      private:
+        DSP::BiquadBank<DSP::BiquadFilterType::Peak, NumChannels> sut{};
+        std::array<std::array<float, BlockSize>, NumChannels> m_data{};
+        std::array<float*, NumChannels> m_pointers{};
+        size_t m_samplesProcessed{0};
+    };
+
+    const auto seconds = .5f;
+    SUTBase sutBase;
+    SUTOptimized sutOptimized;
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(sutOptimized.samplesProcessed(), seconds, sampleRate);
+}
+
+TEST(BiquadPerformanceTest, compareChebyshevSerialWithStateSpace)
+{
+    constexpr size_t iterationsPerProcess{10};
+    constexpr size_t BlockSize{256};
+    constexpr float sampleRate{48000.f};
+
+    class SUT
+    {
+      public:
+        explicit SUT(const DSP::ChebyshevBiquad::Processing processing)
+        {
+            sut.setSampleRate(sampleRate);
+            sut.computeType1(DSP::ChebyshevBiquad::MAX_ORDER, 1000.f, 3, true);
+            sut.setProcessing(processing);
+        }
+
+        void process()
+        {
+            for (size_t i = 0; i < iterationsPerProcess; ++i)
+            {
+                m_data[0] = 1.f;
+                sut.processBlock(m_data.data(), m_data.data(), BlockSize);
+                EXPECT_NE(m_data[0], 0);
+            }
+            m_samplesProcessed += iterationsPerProcess * BlockSize;
+        }
+
+        size_t samplesProcessed() const
+        {
+            return m_samplesProcessed;
+        }
+
+      private:
+        DSP::ChebyshevBiquad sut{};
+        std::array<float, BlockSize> m_data{};
+        size_t m_samplesProcessed{0};
+    };
+
+    const auto seconds = .5f;
+    SUT sutBase{DSP::ChebyshevBiquad::Processing::Serial};
+    SUT sutOptimized{DSP::ChebyshevBiquad::Processing::StateSpace8};
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(sutOptimized.samplesProcessed(), seconds, sampleRate);
+}
+
+TEST(BiquadPerformanceTest, compareChebyshevStereoSerialWithPipelined)
+{
+    constexpr size_t iterationsPerProcess{10};
+    constexpr size_t BlockSize{256};
+    constexpr float sampleRate{48000.f};
+
+    class SUT
+    {
+      public:
+        explicit SUT(const DSP::ChebyshevBiquad::Processing processing)
+        {
+            sut.setSampleRate(sampleRate);
+            sut.computeType1(DSP::ChebyshevBiquad::MAX_ORDER, 1000.f, 3, true);
+            sut.setProcessing(processing);
+        }
+
+        void process()
+        {
+            for (size_t i = 0; i < iterationsPerProcess; ++i)
+            {
+                m_left[0] = 1.f;
+                m_right[0] = 1.f;
+                sut.processBlockStereo(m_left.data(), m_right.data(), m_left.data(), m_right.data(), BlockSize);
+                EXPECT_NE(m_left[BlockSize - 1], 0);
+            }
+            m_samplesProcessed += iterationsPerProcess * BlockSize;
+        }
+
+        size_t samplesProcessed() const
+        {
+            return m_samplesProcessed;
+        }
+
+      private:
+        DSP::ChebyshevBiquad sut{};
+        std::array<float, BlockSize> m_left{};
+        std::array<float, BlockSize> m_right{};
+        size_t m_samplesProcessed{0};
+    };
+
+    const auto seconds = .5f;
+    SUT sutBase{DSP::ChebyshevBiquad::Processing::Serial};
+    SUT sutOptimized{DSP::ChebyshevBiquad::Processing::Pipelined};
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(sutOptimized.samplesProcessed(), seconds, sampleRate);
+}
+
+TEST(BiquadPerformanceTest, compareStaticWithAutomatedSmooth)
+{
+    constexpr size_t iterationsPerProcess{10};
+    constexpr size_t BlockSize{256};
+    constexpr float sampleRate{48000.f};
+
+    // no parameter changes at all
+    class SUTBase
+    {
+      public:
+        SUTBase()
+        {
+            sut.computeCoefficients(sampleRate, 1000.f, 0.707f, 3.f);
+        }
+
+        void process()
+        {
+            for (size_t i = 0; i < iterationsPerProcess; ++i)
+            {
+                m_left[0] = 1.f;
+                m_right[0] = 1.f;
+                sut.processBlock(m_left.data(), m_right.data(), m_left.data(), m_right.data(), BlockSize);
+                EXPECT_NE(m_left[0], 0);
+            }
+        }
+
+      private:
+        DSP::BiquadStereo<DSP::BiquadFilterType::Peak> sut{};
+        std::array<float, BlockSize> m_left{};
+        std::array<float, BlockSize> m_right{};
+    };
+
+    // a new frequency for every block, ramped over the full block
+    class SUTOptimized
+    {
+      public:
+        SUTOptimized()
+        {
+            sut.setSmoothingSteps(BlockSize);
+        }
+
+        void process()
+        {
+            for (size_t i = 0; i < iterationsPerProcess; ++i)
+            {
+                m_frequency = m_frequency > 10000.f ? 100.f : m_frequency * 1.01f;
+                sut.computeCoefficients(sampleRate, m_frequency, 0.707f, 3.f);
+                m_left[0] = 1.f;
+                m_right[0] = 1.f;
+                sut.processBlock(m_left.data(), m_right.data(), m_left.data(), m_right.data(), BlockSize);
+                EXPECT_NE(m_left[0], 0);
+            }
+            m_samplesProcessed += iterationsPerProcess * BlockSize;
+        }
+
+        size_t samplesProcessed() const
+        {
+            return m_samplesProcessed;
+        }
+
+      private:
+        DSP::BiquadStereoSmooth<DSP::BiquadFilterType::Peak> sut{};
+        std::array<float, BlockSize> m_left{};
+        std::array<float, BlockSize> m_right{};
+        float m_frequency{100.f};
+        size_t m_samplesProcessed{0};
+    };
+
+    const auto seconds = .5f;
+    SUTBase sutBase;
+    SUTOptimized sutOptimized;
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(sutOptimized.samplesProcessed(), seconds, sampleRate);
+}
+
+TEST(BiquadPerformanceTest, coefficientUpdatesPerSecond)
+{
+    constexpr size_t numUpdates{200000};
+    constexpr float sampleRate{48000.f};
+    // an automation sweep that comes back to the same frequencies, like an lfo
+    const auto frequencyAt = [](const size_t i) { return 200.f + 10.f * static_cast<float>(i % 100); };
+    const auto measure = [numUpdates](const char* name, const auto& update)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < numUpdates; ++i)
+        {
+            update(i);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const auto seconds = std::chrono::duration<double>(stop - start).count();
+        std::cout << name << ": " << static_cast<double>(numUpdates) / seconds / 1'000'000. << " M updates/second"
+                  << std::endl;
+        return seconds;
+    };
+
+    DSP::BiquadCoefficients biquad;
+    const auto biquadUpdate = [&](const size_t i)
+    { biquad.coefficients(DSP::BiquadFilterType::Peak, sampleRate, frequencyAt(i), 0.707f, 3.f); };
+    const auto exact = measure("biquad exact", biquadUpdate);
+    biquad.setCoefficientMath(DSP::CoefficientMath::Fast);
+    const auto fast = measure("biquad fast math", biquadUpdate);
+    DSP::BiquadCoefficientCache biquadCache;
+    biquad.setCoefficientMath(DSP::CoefficientMath::Exact);
+    biquad.setCoefficientCache(&biquadCache);
+    const auto cached = measure("biquad cached", biquadUpdate);
+    EXPECT_NE(biquad.getCoefficients().b0, 1.f);
+    EXPECT_LT(fast, exact);
+    EXPECT_LT(cached, exact);
+
+    DSP::ChebyshevBiquad chebyshev;
+    chebyshev.setSampleRate(sampleRate);
+    const auto chebyshevUpdate = [&](const size_t i) { chebyshev.computeType1(8, frequencyAt(i), 3, true); };
+    const auto chebyshevExact = measure("chebyshev order 8 exact", chebyshevUpdate);
+    DSP::ChebyshevBiquad::Cache chebyshevCache;
+    chebyshev.setCoefficientCache(&chebyshevCache);
+    const auto chebyshevCached = measure("chebyshev order 8 cached", chebyshevUpdate);
+    EXPECT_LT(chebyshevCached, chebyshevExact);
+}
 }
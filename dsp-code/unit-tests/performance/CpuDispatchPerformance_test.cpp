@@ -0,0 +1,134 @@
+
+#include "Biquad.h"
+#include "CpuDispatch.h"
+#include "CrossFader.h"
+#include "DigitalDelay.h"
+#include "OnePoleFilter.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace DspPerformanceTest
+{
+
+namespace
+{
+const char* isaName(const DSP::Isa isa)
+{
+    switch (isa)
+    {
+        case DSP::Isa::Avx2:
+            return "avx2";
+        case DSP::Isa::Avx512:
+            return "avx512";
+        default:
+            return "generic";
+    }
+}
+
+template <typename Process>
+double measure(Process& process)
+{
+    constexpr size_t repetitions{2000};
+    process(); // warm up
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; ++i)
+    {
+        process();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) / 1000.0;
+}
+
+// prints the time of the baseline, the same work without dispatch(), and of the process for every instruction set
+// the cpu supports, a dispatched kernel slower than its baseline in every column doesn't belong dispatched
+template <typename Baseline, typename Process>
+void compareIsaVariants(const char* name, Baseline&& baseline, Process&& process)
+{
+    std::cout << name << " baseline: " << measure(baseline) << " ms" << std::endl;
+    for (const auto isa : {DSP::Isa::Generic, DSP::Isa::Avx2, DSP::Isa::Avx512})
+    {
+        if (!DSP::forceIsa(isa))
+        {
+            continue;
+        }
+        std::cout << name << " " << isaName(isa) << ": " << measure(process) << " ms" << std::endl;
+    }
+    DSP::resetIsa();
+}
+}
+
+TEST(CpuDispatchPerformanceTest, compareVariants)
+{
+    constexpr size_t NumChannels{16};
+    constexpr size_t blockSize{512};
+    std::vector<float> interleaved(blockSize * NumChannels, 0.f);
+    interleaved[0] = 1.f;
+    DSP::BiquadBank<DSP::BiquadFilterType::Peak, NumChannels> bank;
+    bank.computeCoefficients(48000.f, 1000.f, 0.707f, 6.f);
+    std::array<DSP::Biquad<DSP::BiquadFilterType::Peak>, NumChannels> biquads;
+    std::vector<float> planar(blockSize * NumChannels, 0.f);
+    for (auto& biquad : biquads)
+    {
+        biquad.computeCoefficients(48000.f, 1000.f, 0.707f, 6.f);
+    }
+    compareIsaVariants(
+        "BiquadBank interleaved",
+        [&]()
+        {
+            for (size_t c = 0; c < NumChannels; ++c)
+            {
+                biquads[c].processBlock(planar.data() + c * blockSize, blockSize);
+            }
+        },
+        [&]() { bank.processBlockInterleaved(interleaved.data(), interleaved.data(), blockSize); });
+
+    std::vector<float> source(blockSize + 3, 0.5f);
+    std::vector<float> out(blockSize, 0.f);
+    DSP::OnePoleFilter onePole(48000.f, 1000.f);
+    DSP::OnePoleFilterOptimized onePoleScan(48000.f, 1000.f);
+    compareIsaVariants(
+        "OnePoleFilterOptimized", [&]() { onePole.processBlock(source.data(), out.data(), blockSize); },
+        [&]() { onePoleScan.processBlock(source.data(), out.data(), blockSize); });
+
+    DSP::CrossFader fader;
+    compareIsaVariants(
+        "CrossFader",
+        [&]()
+        {
+            fader.reset(blockSize);
+            for (size_t i = 0; i < blockSize; ++i)
+            {
+                out[i] = fader.step(source[i], source[i + 1]);
+            }
+        },
+        [&]()
+        {
+            fader.reset(blockSize);
+            fader.processBlock(source.data(), source.data() + 1, out.data(), blockSize);
+        });
+
+    constexpr size_t readSize{DSP::DelayBuffer<DSP::DelayWrapping::Modulo>::MaxBlockSize};
+    DSP::DelayBuffer<DSP::DelayWrapping::Modulo> delay(48000);
+    std::vector<float> distances(readSize);
+    for (size_t i = 0; i < readSize; ++i)
+    {
+        distances[i] = 1000.f + 0.37f * static_cast<float>(i);
+    }
+    compareIsaVariants(
+        "DelayBuffer readBlock",
+        [&]()
+        {
+            for (size_t i = 0; i < readSize; ++i)
+            {
+                out[i] = delay.read(24000 + i, distances[i]);
+            }
+        },
+        [&]() { delay.readBlock(24000, distances.data(), out.data(), readSize); });
+    EXPECT_EQ(DSP::activeIsa(), DSP::detectIsa());
+}
+}
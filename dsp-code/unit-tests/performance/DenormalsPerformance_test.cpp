@@ -0,0 +1,104 @@
+
+#include "Biquad.h"
+#include "Denormals.h"
+#include "OnePoleFilter.h"
+#include "TwoLatticeAllPass.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+
+namespace DspPerformanceTest
+{
+
+namespace
+{
+// one voice of recursive filters fed with an impulse followed by silence, microseconds per second of audio
+// for the first second and for the slowest of the following ones
+template <typename Setup>
+std::pair<double, double> renderImpulseTail(Setup&& setup)
+{
+    constexpr float sampleRate{48000.f};
+    constexpr size_t seconds{20};
+    constexpr size_t blockSize{128};
+    constexpr size_t blocksPerSecond{static_cast<size_t>(sampleRate) / blockSize};
+
+    DSP::OnePoleFilter onePole(sampleRate, 100.f);
+    DSP::Biquad<DSP::BiquadFilterType::LowPass> biquad;
+    biquad.computeCoefficients(sampleRate, 100.f, 0.707f, 0.f);
+    DSP::TwoLatticeAllPass<1000> allPass(sampleRate);
+    allPass.setSize(700);
+    allPass.setFeedback(0.7f);
+    setup(onePole, biquad, allPass);
+
+    std::array<float, blockSize> impulse{};
+    impulse[0] = 1.f;
+    std::array<float, blockSize> block{};
+    double first{0};
+    double slowest{0};
+    for (size_t second = 0; second < seconds; ++second)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < blocksPerSecond; ++i)
+        {
+            onePole.processBlock(impulse.data(), block.data(), block.size());
+            impulse[0] = 0.f;
+            biquad.processBlock(block.data(), block.size());
+            allPass.processBlockInplace(block.data(), block.size());
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const auto micros =
+            static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()) / 1000.;
+        if (second == 0)
+        {
+            first = micros;
+        }
+        else
+        {
+            slowest = std::max(slowest, micros);
+        }
+    }
+    EXPECT_LT(std::abs(block[0]), 1E-6f);
+    return {first, slowest};
+}
+
+void print(const char* name, const std::pair<double, double>& result)
+{
+    std::cout << name << ": first second " << result.first << " us, slowest tail second " << result.second
+              << " us r: " << static_cast<int>(result.second * 100 / result.first) << "%" << std::endl;
+}
+}
+
+TEST(DenormalsPerformanceTest, impulseFollowedBySilence)
+{
+    const auto noop = [](auto&, auto&, auto&) {};
+    const auto plain = renderImpulseTail(noop);
+    print("no flushing", plain);
+
+    std::pair<double, double> guarded;
+    {
+        DSP::ScopedFlushDenormals guard;
+        guarded = renderImpulseTail(noop);
+    }
+    print("ScopedFlushDenormals", guarded);
+
+    const auto flushed = renderImpulseTail(
+        [](auto& onePole, auto& biquad, auto& allPass)
+        {
+            onePole.setFlushDenormals(true);
+            biquad.setFlushDenormals(true);
+            allPass.setFlushDenormals(true);
+        });
+    print("setFlushDenormals", flushed);
+
+    // the tails decay into zeros instead of subnormals, so the silence is not slower than the first second
+    if (DSP::ScopedFlushDenormals::isAvailable())
+    {
+        EXPECT_LT(guarded.second, guarded.first * 2);
+    }
+    EXPECT_LT(flushed.second, flushed.first * 2);
+}
+}
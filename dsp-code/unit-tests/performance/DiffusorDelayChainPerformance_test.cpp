@@ -0,0 +1,183 @@
+
+#include "DiffusorDelayChain.h"
+#include "TwoLatticeAllPass.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace DspPerformanceTest
+{
+
+// the chain of KindOfADelay fused against one pass per allpass over the block, 60 seconds
+TEST(DiffusorDelayChainPerformanceTest, compareFusedWithSeparatePasses)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    constexpr float sampleRate{48000.f};
+    constexpr std::array<size_t, 5> elementSizes{172, 229, 447, 611, 1176};
+    constexpr size_t numSamples{static_cast<size_t>(sampleRate) * 60};
+    const auto measure = [](auto&& process, const size_t blockSize)
+    {
+        std::vector<float> data(blockSize);
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t index = 0; index + blockSize <= numSamples; index += blockSize)
+        {
+            data[0] = 1.f;
+            process(data.data(), blockSize);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        EXPECT_NE(data[0], 20.f);
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) /
+               1000.0;
+    };
+
+    for (const size_t blockSize : {16, 128})
+    {
+        DSP::DiffusorDelayChain<5000, 5> fused{sampleRate};
+        fused.setMix(1.f);
+        std::vector<DSP::TwoLatticeAllPass<5000>> separate(5, DSP::TwoLatticeAllPass<5000>(sampleRate));
+        for (size_t element = 0; element < elementSizes.size(); ++element)
+        {
+            fused.setElementSize(element, elementSizes[element]);
+            separate[element].setSize(fused.getUsefulPrime(101, static_cast<unsigned>(elementSizes[element])));
+            separate[element].setFeedback(0.65f);
+            separate[element].setLowpassCutoff(8000.f);
+        }
+        const auto base = measure(
+            [&](float* data, const size_t n)
+            {
+                for (auto& allPass : separate)
+                {
+                    allPass.processBlockInplace(data, n);
+                }
+            },
+            blockSize);
+        const auto optimized = measure([&](float* data, const size_t n) { fused.processBlock(data, data, n); },
+                                       blockSize);
+        std::cout << "blocks of " << blockSize << ", separate passes: " << base << " ms, fused: " << optimized
+                  << " ms r: " << static_cast<int>(base * 100 / optimized) << "%" << std::endl;
+    }
+}
+
+// NumChannels chains against one network, blocks of 16 as in KindOfADelay, 60 seconds
+template <size_t NumChannels>
+void compareNetworkWithChains()
+{
+    constexpr float sampleRate{48000.f};
+    constexpr std::array<size_t, 5> elementSizes{172, 229, 447, 611, 1176};
+    constexpr size_t blockSize{16};
+    constexpr size_t numSamples{static_cast<size_t>(sampleRate) * 60};
+    using Diffusor = DSP::DiffusorDelayChain<5000, 5>;
+    std::vector<Diffusor> chains;
+    DSP::DiffusorNetwork<5000, 5, NumChannels> network{sampleRate};
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        chains.emplace_back(sampleRate);
+        chains[c].setMix(1.f);
+        for (size_t element = 0; element < elementSizes.size(); ++element)
+        {
+            chains[c].setElementSize(element, elementSizes[element] + c * 10);
+            network.setElementSize(c, element, elementSizes[element] + c * 10);
+        }
+    }
+    network.setMix(1.f);
+
+    std::array<std::array<float, blockSize>, NumChannels> data{};
+    std::array<float*, NumChannels> channels{};
+    for (size_t c = 0; c < NumChannels; ++c)
+    {
+        channels[c] = data[c].data();
+    }
+    const auto measure = [&](auto&& process)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t index = 0; index + blockSize <= numSamples; index += blockSize)
+        {
+            data[0][0] = 1.f;
+            process();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        EXPECT_NE(data[0][0], 20.f);
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) /
+               1000.0;
+    };
+    const auto base = measure(
+        [&]
+        {
+            for (size_t c = 0; c < NumChannels; ++c)
+            {
+                chains[c].processBlock(channels[c], channels[c], blockSize);
+            }
+        });
+    const auto optimized = measure([&] { network.processBlock(channels.data(), channels.data(), blockSize); });
+    network.setStageMixing(true);
+    const auto mixed = measure([&] { network.processBlock(channels.data(), channels.data(), blockSize); });
+    std::cout << NumChannels << " channels, chains: " << base << " ms, network: " << optimized
+              << " ms, with stage mixing: " << mixed << " ms r: " << static_cast<int>(base * 100 / optimized) << "%"
+              << std::endl;
+}
+
+TEST(DiffusorDelayChainPerformanceTest, compareNetworkWithChains)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    compareNetworkWithChains<2>();
+    compareNetworkWithChains<4>();
+    compareNetworkWithChains<8>();
+}
+
+// the sizes of a diffusor at a session load, trial division of each candidate against the table
+TEST(DiffusorDelayChainPerformanceTest, compareSizing)
+{
+    constexpr std::array<size_t, 10> widths{172, 229, 447, 611, 1176, 182, 219, 437, 631, 1098};
+    constexpr std::array<float, 4> sampleRates{44100.f, 48000.f, 96000.f, 192000.f};
+    constexpr size_t numInstances{200000};
+    const auto byTrialDivision = [](const unsigned minimumValue, const unsigned wIn)
+    {
+        auto n = std::max(minimumValue, wIn) | 1u;
+        for (size_t m = 0; m < 250u && !DSP::isPrimeByTrialDivision(n); ++m)
+        {
+            n += 2u;
+        }
+        return n;
+    };
+
+    size_t sum{0};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t instance = 0; instance < numInstances; ++instance)
+    {
+        const auto sampleRate = sampleRates[instance % sampleRates.size()];
+        for (const auto width : widths)
+        {
+            sum += byTrialDivision(101, static_cast<unsigned>(static_cast<float>(width) * sampleRate / 48000.f));
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    const auto base =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) / 1000.0;
+
+    size_t tableSum{0};
+    start = std::chrono::steady_clock::now();
+    for (size_t instance = 0; instance < numInstances; ++instance)
+    {
+        const auto lengths = DSP::computeDiffusorLengths(widths, sampleRates[instance % sampleRates.size()]);
+        for (const auto length : lengths)
+        {
+            tableSum += length;
+        }
+    }
+    stop = std::chrono::steady_clock::now();
+    const auto optimized =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) / 1000.0;
+    EXPECT_GE(tableSum, sum); // sizes that meet the same prime move on to the next one
+    std::cout << numInstances << " diffusors, trial division: " << base << " ms, prime table: " << optimized
+              << " ms r: " << static_cast<int>(base * 100 / optimized) << "%" << std::endl;
+}
+}
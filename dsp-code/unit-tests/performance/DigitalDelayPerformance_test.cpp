@@ -4,7 +4,11 @@
 #include "DigitalDelay.h"
 #include "DspPerformance.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <memory>
+#include <vector>
 
 namespace DspPerformanceTest
 {
@@ -140,4 +144,314 @@ TEST(DigitalDelayPerformanceTest, compareOlder)
     testCompare.printResult(sutOptimized.samplesProcessed(), seconds, sampleRate);
 }
 
+namespace
+{
+template <typename Delay>
+class DelaySUT
+{
+  public:
+    static constexpr size_t IterationsPerProcess{10};
+    static constexpr float SampleRate{48000.f};
+
+    DelaySUT()
+        : sut(SampleRate)
+    {
+    }
+
+    void process()
+    {
+        for (size_t i = 0; i < IterationsPerProcess; ++i)
+        {
+            m_data[0] = 1.f;
+            sut.processBlock(m_data.data(), m_data.data(), m_data.size());
+            EXPECT_NE(m_data[0], 20);
+        }
+        m_samplesProcessed += IterationsPerProcess * m_data.size();
+    }
+
+    size_t samplesProcessed() const
+    {
+        return m_samplesProcessed;
+    }
+
+  private:
+    Delay sut;
+    std::array<float, 1024> m_data{};
+    size_t m_samplesProcessed{0};
+};
+
+template <typename BaseDelay, typename OptimizedDelay>
+void compareDelays()
+{
+    const auto seconds = .5f;
+    DelaySUT<BaseDelay> sutBase;
+    DelaySUT<OptimizedDelay> sutOptimized;
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(sutOptimized.samplesProcessed(), seconds, DelaySUT<OptimizedDelay>::SampleRate);
+}
+}
+
+// the bitmask wrapping against the modulo of DigitalDelay and the block check of DigitalDelayOptimized
+TEST(DigitalDelayPerformanceTest, comparePowerOfTwo)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    using PowerOfTwo = DSP::DigitalDelay<1000, DSP::DelayWrapping::PowerOfTwo>;
+    std::cout << "DigitalDelay vs power of two" << std::endl;
+    compareDelays<DSP::DigitalDelay<1000>, PowerOfTwo>();
+    std::cout << "DigitalDelayOptimized vs power of two" << std::endl;
+    compareDelays<DSP::DigitalDelayOptimized<1000>, PowerOfTwo>();
+}
+
+// step() per sample against the block path, modulated and with a time change every 10000 samples
+TEST(DigitalDelayPerformanceTest, compareStepWithBlock)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    constexpr float sampleRate{48000.f};
+    DSP::DigitalDelay<1000> stepped(sampleRate);
+    DSP::DigitalDelay<1000> blocked(sampleRate);
+    std::array<float, 1024> steppedData{};
+    std::array<float, 1024> blockedData{};
+    size_t steppedSamples{0};
+    size_t blockedSamples{0};
+    const auto setup = [](auto& delay, size_t& samples)
+    {
+        if (samples % 10240 == 0)
+        {
+            delay.setModulationDepth(20.f);
+            delay.setModulationSpeed(1.f);
+            delay.setTime(samples % 20480 == 0 ? 0.3f : 0.4f);
+        }
+        samples += 1024;
+    };
+    const auto baseRunner = [&]()
+    {
+        setup(stepped, steppedSamples);
+        steppedData[0] = 1.f;
+        for (auto& value : steppedData)
+        {
+            value = stepped.step(value);
+        }
+    };
+    const auto optimizedRunner = [&]()
+    {
+        setup(blocked, blockedSamples);
+        blockedData[0] = 1.f;
+        blocked.processBlock(blockedData.data(), blockedData.data(), blockedData.size());
+    };
+
+    const auto seconds = .5f;
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(blockedSamples, seconds, sampleRate);
+}
+
+// 8 taps on one buffer against 8 DigitalDelays mixed to stereo, 10 seconds of buffer each
+TEST(DigitalDelayPerformanceTest, compareMultiTapWithSeparateDelays)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    constexpr float sampleRate{48000.f};
+    constexpr size_t NumTaps{8};
+    constexpr size_t blockSize{512};
+    std::vector<DSP::DigitalDelay<10000>> delays(NumTaps, DSP::DigitalDelay<10000>(sampleRate));
+    DSP::MultiTapDelay<10000, NumTaps> multiTap(sampleRate);
+    std::array<DSP::PanValues<float>, NumTaps> gains{};
+    for (size_t tap = 0; tap < NumTaps; ++tap)
+    {
+        const auto seconds = 0.3f * static_cast<float>(tap + 1);
+        const auto pan = static_cast<float>(tap) / (NumTaps - 1) * 2.f - 1.f;
+        delays[tap].setTime(seconds);
+        delays[tap].setModulationDepth(10.f);
+        delays[tap].setModulationSpeed(0.3f + 0.1f * static_cast<float>(tap));
+        gains[tap] = DSP::getPanFactor(pan);
+        multiTap.setTime(tap, seconds);
+        multiTap.setModulationDepth(tap, 10.f);
+        multiTap.setModulationSpeed(tap, 0.3f + 0.1f * static_cast<float>(tap));
+        multiTap.setGainAndPan(tap, 1.f, pan);
+    }
+
+    std::array<float, blockSize> in{};
+    std::array<float, blockSize> delayed{};
+    std::array<float, blockSize> left{};
+    std::array<float, blockSize> right{};
+    size_t samplesProcessed{0};
+    const auto baseRunner = [&]()
+    {
+        in[0] = 1.f;
+        std::fill(left.begin(), left.end(), 0.f);
+        std::fill(right.begin(), right.end(), 0.f);
+        for (size_t tap = 0; tap < NumTaps; ++tap)
+        {
+            delays[tap].processBlock(in.data(), delayed.data(), blockSize);
+            for (size_t i = 0; i < blockSize; ++i)
+            {
+                left[i] += gains[tap].left * delayed[i];
+                right[i] += gains[tap].right * delayed[i];
+            }
+        }
+        EXPECT_NE(left[0], 20.f);
+    };
+    const auto optimizedRunner = [&]()
+    {
+        in[0] = 1.f;
+        multiTap.processBlock(in.data(), left.data(), right.data(), blockSize);
+        EXPECT_NE(left[0], 20.f);
+        samplesProcessed += blockSize;
+    };
+
+    size_t separateMemory{0};
+    for (const auto& delay : delays)
+    {
+        separateMemory += delay.memoryInBytes();
+    }
+    std::cout << "memory of " << NumTaps << " DigitalDelays: " << separateMemory / 1024 << " kB, MultiTapDelay: "
+              << multiTap.memoryInBytes() / 1024 << " kB" << std::endl;
+    EXPECT_EQ(multiTap.memoryInBytes() * NumTaps, separateMemory);
+
+    const auto seconds = .5f;
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(samplesProcessed, seconds, sampleRate);
+}
+
+// a new delay time every block of 64 samples (fast tempo automation) for each way of following it, and without
+// changes for reference
+TEST(DigitalDelayPerformanceTest, timeChangeAutomationBurst)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    constexpr float sampleRate{48000.f};
+    constexpr size_t blockSize{64};
+    constexpr size_t numBlocks{static_cast<size_t>(sampleRate) * 10 / blockSize};
+    const auto render = [&](const auto timeChange, const bool automate)
+    {
+        DSP::DigitalDelay<1000> sut(sampleRate);
+        sut.setModulationDepth(10.f);
+        sut.setModulationSpeed(0.5f);
+        sut.setTimeChange(timeChange);
+        std::array<float, blockSize> data{};
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t block = 0; block < numBlocks; ++block)
+        {
+            if (automate)
+            {
+                sut.setTime(0.25f + 0.05f * std::sin(static_cast<float>(block) * 0.01f));
+            }
+            data[0] = 1.f;
+            sut.processBlock(data.data(), data.data(), blockSize);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        EXPECT_NE(data[0], 20.f);
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) /
+               1000.0;
+    };
+
+    const auto unchanged = render(DSP::DelayTimeChange::Crossfade, false);
+    std::cout << "10 seconds without time changes: " << unchanged << " ms" << std::endl;
+    const std::array<std::pair<const char*, DSP::DelayTimeChange>, 3> timeChanges{
+        {{"Crossfade", DSP::DelayTimeChange::Crossfade},
+         {"AdaptiveCrossfade", DSP::DelayTimeChange::AdaptiveCrossfade},
+         {"Glide", DSP::DelayTimeChange::Glide}}};
+    for (const auto& [name, timeChange] : timeChanges)
+    {
+        const auto msecs = render(timeChange, true);
+        std::cout << "10 seconds with a time change every " << blockSize << " samples, " << name << ": " << msecs
+                  << " ms r: " << static_cast<int>(unchanged * 100 / msecs) << "%" << std::endl;
+    }
+}
+
+namespace
+{
+// numInstances delays of 250 msecs processed one block each in turn for 10 seconds, the delay lines of all instances
+// together are the working set, milliseconds
+template <DSP::DelayStorage Storage>
+double renderInstances(const size_t numInstances)
+{
+    constexpr float sampleRate{48000.f};
+    constexpr size_t blockSize{64};
+    constexpr size_t numBlocks{static_cast<size_t>(sampleRate) * 10 / blockSize};
+    using Delay = DSP::DigitalDelay<1000, DSP::DelayWrapping::Modulo, Storage>;
+    std::vector<Delay> delays(numInstances, Delay(sampleRate));
+    for (auto& delay : delays)
+    {
+        delay.setTime(0.25f);
+        delay.setModulationDepth(10.f);
+        delay.setModulationSpeed(0.5f);
+    }
+    std::array<float, blockSize> data{};
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+        for (auto& delay : delays)
+        {
+            data[0] = 0.5f;
+            delay.processBlock(data.data(), data.data(), blockSize);
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    EXPECT_NE(data[0], 20.f);
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) / 1000.0;
+}
+}
+
+// the conversions cost more than they save with one instance, with many the smaller working set pays
+TEST(DigitalDelayPerformanceTest, compareStorageWithManyInstances)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    for (const size_t numInstances : {1, 64, 256})
+    {
+        const auto floats = renderInstances<DSP::DelayStorage::Float32>(numInstances);
+        const auto int16s = renderInstances<DSP::DelayStorage::Int16>(numInstances);
+        const auto halfs = renderInstances<DSP::DelayStorage::Half>(numInstances);
+        std::cout << numInstances << " instances for 10 seconds, Float32: " << floats << " ms, Int16: " << int16s
+                  << " ms r: " << static_cast<int>(floats * 100 / int16s) << "%, Half: " << halfs
+                  << " ms r: " << static_cast<int>(floats * 100 / halfs) << "%" << std::endl;
+    }
+}
+
+// creating many instances of a 10 seconds delay that only need the default time
+TEST(DigitalDelayPerformanceTest, compareGrowingStartup)
+{
+    constexpr float sampleRate{48000.f};
+    constexpr size_t numInstances{100};
+    const auto create = [&](auto instance)
+    {
+        using Delay = typename decltype(instance)::element_type;
+        std::vector<std::unique_ptr<Delay>> delays;
+        const auto start = std::chrono::steady_clock::now();
+        size_t memory{0};
+        for (size_t i = 0; i < numInstances; ++i)
+        {
+            delays.push_back(std::make_unique<Delay>(sampleRate));
+            memory += delays.back()->memoryInBytes();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        std::cout << numInstances << " instances: "
+                  << static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) /
+                         1000.0
+                  << " ms, " << memory / 1024 << " kB" << std::endl;
+        return memory;
+    };
+    std::cout << "DigitalDelay<10000> ";
+    const auto full = create(std::unique_ptr<DSP::DigitalDelay<10000>>{});
+    std::cout << "GrowingDigitalDelay<10000> ";
+    const auto growing = create(std::unique_ptr<DSP::GrowingDigitalDelay<10000>>{});
+    EXPECT_LT(growing * 10, full);
+}
 }
@@ -1,13 +1,19 @@
 
 #include "DspPerformance.h"
 
+#include "DigitalDelay.h"
 #include "FourStageFilter.h"
+#include "TwoLatticeAllPass.h"
 
 #include "gtest/gtest.h"
 
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
 
 namespace DspPerformanceTest
 {
@@ -18,7 +24,8 @@ class FourStageMultiFilter2
   public:
     FourStageMultiFilter2(const float sampleRate)
         : m_sampleRate(sampleRate)
-        , lp{sampleRate, sampleRate, sampleRate, sampleRate}
+        , lp{DSP::OnePoleFilter(sampleRate), DSP::OnePoleFilter(sampleRate), DSP::OnePoleFilter(sampleRate),
+             DSP::OnePoleFilter(sampleRate)}
     {
         setCutoff(1000.f);
         m_stepsadvance = 0;
@@ -117,6 +124,198 @@ class FourStageMultiFilter2
     std::array<DSP::OnePoleFilter, 4> lp;
 };
 
+// the filter as it was before FourStageFilter became a crtp base, singleStep was called virtually for every sample
+class FourStageFilterVirtual
+{
+  public:
+    explicit FourStageFilterVirtual(const float sampleRate)
+        : m_sampleRate(sampleRate)
+    {
+        setCutoff(1000.f);
+        m_stepsadvance = 0;
+        m_pole = m_newpole;
+    }
+
+    virtual ~FourStageFilterVirtual() = default;
+
+    void setResonance(float value)
+    {
+        m_reso = value * 4.0f;
+    }
+
+    void setCutoff(const float cutoff)
+    {
+        m_newpole = std::exp(-2.0f * static_cast<float>(M_PI) * cutoff / m_sampleRate);
+        m_stepsadvance = m_stepsadvanceSetting;
+        m_advance = (m_newpole - m_pole) / static_cast<float>(m_stepsadvance);
+    }
+
+    virtual float singleStep(float in) = 0;
+
+    void processBlock(float* source, size_t numSamples)
+    {
+        size_t index = 0;
+        size_t toIndex = numSamples;
+        if (m_stepsadvance)
+        {
+            if (m_stepsadvance < numSamples)
+            {
+                toIndex = m_stepsadvance;
+                m_stepsadvance = 0;
+            }
+            else
+            {
+                m_stepsadvance -= numSamples;
+            }
+            while (index < toIndex)
+            {
+                m_pole += m_advance;
+                source[index] = singleStep(source[index]);
+                ++index;
+            }
+            if (!m_stepsadvance)
+            {
+                m_pole = m_newpole;
+            }
+        }
+        while (index < numSamples)
+        {
+            source[index] = singleStep(source[index]);
+            ++index;
+        }
+    }
+
+  private:
+    float m_sampleRate;
+    float m_advance{0};
+    size_t m_stepsadvance{0};
+    size_t m_stepsadvanceSetting{256u};
+    float m_newpole{0.5};
+
+  protected:
+    float m_reso{0.0};
+    float m_pole{0.5};
+    std::array<float, 4> m_v{0, 0, 0, 0};
+};
+
+template <std::array<float, 5> f>
+class FourStageMultiFilterVirtual : public FourStageFilterVirtual
+{
+  public:
+    using FourStageFilterVirtual::FourStageFilterVirtual;
+
+    float singleStep(const float in) override
+    {
+        auto feed = in - m_v[3] * m_reso;
+        m_v[0] = feed + m_pole * (m_v[0] - feed);
+        m_v[1] = m_v[0] + m_pole * (m_v[1] - m_v[0]);
+        m_v[2] = m_v[1] + m_pole * (m_v[2] - m_v[1]);
+        m_v[3] = m_v[2] + m_pole * (m_v[3] - m_v[2]);
+        return f[0] * feed + f[1] * m_v[0] + f[2] * m_v[1] + f[3] * m_v[2] + f[4] * m_v[3];
+    }
+};
+
+// the mode of the virtual design is picked at runtime by creating one of the derived filters
+class FourStageFilterVirtualByMode
+{
+  public:
+    FourStageFilterVirtualByMode(const float sampleRate, const DSP::FourStageMode mode)
+        : m_filter(create(sampleRate, mode, std::make_index_sequence<DSP::FourStageModeFactors.size()>{}))
+    {
+    }
+
+    void setResonance(const float value)
+    {
+        m_filter->setResonance(value);
+    }
+
+    void setCutoff(const float cutoff)
+    {
+        m_filter->setCutoff(cutoff);
+    }
+
+    void processBlock(float* source, const size_t numSamples)
+    {
+        m_filter->processBlock(source, numSamples);
+    }
+
+  private:
+    template <size_t... Mode>
+    static std::unique_ptr<FourStageFilterVirtual> create(const float sampleRate, const DSP::FourStageMode mode,
+                                                          std::index_sequence<Mode...>)
+    {
+        std::unique_ptr<FourStageFilterVirtual> filter;
+        ((static_cast<size_t>(mode) == Mode
+              ? filter = std::make_unique<FourStageMultiFilterVirtual<DSP::FourStageModeFactors[Mode]>>(sampleRate)
+              : filter),
+         ...);
+        return filter;
+    }
+
+    std::unique_ptr<FourStageFilterVirtual> m_filter;
+};
+
+namespace
+{
+// a filter processing blocks of noise in place, the cutoff is moved every block so the smoothing is part of it
+template <typename Filter>
+class FourStageRunner
+{
+  public:
+    template <typename... Args>
+    explicit FourStageRunner(Args&&... args)
+        : m_filter(std::forward<Args>(args)...)
+    {
+        m_filter.setResonance(0.2f);
+        std::mt19937 generator(3);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        std::generate(m_noise.begin(), m_noise.end(), [&]() { return distribution(generator); });
+    }
+
+    Filter& filter()
+    {
+        return m_filter;
+    }
+
+    void process()
+    {
+        m_cutoff = m_cutoff > 8000.f ? 200.f : m_cutoff * 1.1f;
+        m_filter.setCutoff(m_cutoff);
+        m_data = m_noise;
+        m_filter.processBlock(m_data.data(), m_data.size());
+        EXPECT_TRUE(std::isfinite(m_data[0]));
+    }
+
+  private:
+    Filter m_filter;
+    float m_cutoff{200.f};
+    std::array<float, 512> m_noise{};
+    std::array<float, 512> m_data{};
+};
+
+template <typename Runner>
+double microsecondsFor(Runner&& runner, const size_t iterations)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        runner();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count());
+}
+
+template <typename BaseRunner, typename OptimizedRunner>
+void compareRunners(const char* name, BaseRunner&& baseRunner, OptimizedRunner&& optimizeRunner)
+{
+    constexpr size_t iterations{20000};
+    const auto base = microsecondsFor(baseRunner, iterations);
+    const auto optimized = microsecondsFor(optimizeRunner, iterations);
+    std::cout << name << " Base: " << base / 1000.0 << " ms Optimized: " << optimized / 1000.0
+              << " ms r: " << static_cast<int>(base * 100 / optimized) << "%" << std::endl;
+}
+}
+
 TEST(FourPoleFilterPerformanceTest, performance)
 {
     constexpr size_t seconds = 120;
@@ -243,4 +442,168 @@ TEST(FourPoleFilterPerformanceTest, compareOlder)
     }
     std::cout << "Local speed factor: " << sutOptimized.samplesProcessed() / 48000.f / oneBurnInSeconds << std::endl;
 }
+
+
+TEST(FourPoleFilterPerformanceTest, compareVirtualWithCrtp)
+{
+    FourStageRunner<FourStageFilterVirtualByMode> virtualFilter(48000.f, DSP::FourStageMode::Lp24);
+    FourStageRunner<DSP::FourStageMultiModeFilter> crtpFilter(48000.f, DSP::FourStageMode::Lp24);
+    compareRunners("virtual singleStep vs crtp", [&]() { virtualFilter.process(); }, [&]() { crtpFilter.process(); });
+}
+
+// the runtime mode switch against the filter with runtime factors, both can change their mode while running
+TEST(FourPoleFilterPerformanceTest, compareVariableFactorsWithMultiMode)
+{
+    FourStageRunner<DSP::VariableFilter1Pole4StageSmooth> variable(48000.f);
+    FourStageRunner<DSP::FourStageMultiModeFilter> multiMode(48000.f);
+    size_t mode{0};
+    const auto nextMode = [&mode]()
+    {
+        mode = (mode + 1) % DSP::FourStageModeFactors.size();
+        return mode;
+    };
+    size_t blocks{0};
+    compareRunners(
+        "VariableFilter1Pole4StageSmooth vs FourStageMultiModeFilter",
+        [&]()
+        {
+            // a new mode every 64 blocks
+            if (++blocks % 64 == 0)
+            {
+                variable.filter().setFactors(DSP::FourStageModeFactors[nextMode()]);
+            }
+            variable.process();
+        },
+        [&]()
+        {
+            if (++blocks % 64 == 0)
+            {
+                multiMode.filter().setMode(static_cast<DSP::FourStageMode>(nextMode()));
+            }
+            multiMode.process();
+        });
+}
+
+// the feedback path of KindOfADelay (filter, diffusing allpasses and delay) run at 2x as a whole, against the same
+// path at the sample rate with only the zero delay feedback filter oversampled
+template <typename Filter>
+class FeedbackPath
+{
+  public:
+    explicit FeedbackPath(const float sampleRate)
+        : m_filter(sampleRate)
+        , m_allPasses{DSP::TwoLatticeAllPass<5000>(sampleRate), DSP::TwoLatticeAllPass<5000>(sampleRate)}
+        , m_delay(sampleRate)
+    {
+        m_filter.setCutoff(3000.f);
+        m_filter.setResonance(0.7f);
+        m_allPasses[0].setSize(static_cast<size_t>(447.f * sampleRate / 48000.f));
+        m_allPasses[1].setSize(static_cast<size_t>(1176.f * sampleRate / 48000.f));
+        m_delay.setTime(0.3f);
+    }
+
+    void processBlock(float* inPlace, const size_t numSamples)
+    {
+        m_filter.processBlock(inPlace, numSamples);
+        m_allPasses[0].processBlockInplace(inPlace, numSamples);
+        m_allPasses[1].processBlockInplace(inPlace, numSamples);
+        m_delay.processBlock(inPlace, inPlace, numSamples);
+    }
+
+  private:
+    Filter m_filter;
+    std::array<DSP::TwoLatticeAllPass<5000>, 2> m_allPasses;
+    DSP::DigitalDelay<1000> m_delay;
+};
+
+TEST(FourPoleFilterPerformanceTest, compareOversampledPathWithOversampledFilter)
+{
+    constexpr float sampleRate{48000.f};
+    constexpr size_t blockSize{DSP::Oversampler<2>::MaxBlockSize};
+    std::array<float, blockSize> noise{};
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::generate(noise.begin(), noise.end(), [&]() { return distribution(generator); });
+
+    DSP::Oversampler<2> oversampler;
+    FeedbackPath<DSP::MultiModeFourPoleMixerModule> wholePath(sampleRate * 2);
+    std::array<float, blockSize * 2> oversampled{};
+    std::array<float, blockSize> out{};
+    const auto oversampledPath = [&]()
+    {
+        oversampler.upsample(noise.data(), oversampled.data(), blockSize);
+        wholePath.processBlock(oversampled.data(), oversampled.size());
+        oversampler.downsample(oversampled.data(), out.data(), blockSize);
+    };
+
+    FeedbackPath<DSP::ZdfFourPoleMixerModule<2>> filterOnly(sampleRate);
+    std::array<float, blockSize> data{};
+    const auto oversampledFilter = [&]()
+    {
+        data = noise;
+        filterOnly.processBlock(data.data(), data.size());
+    };
+    compareRunners("path at 2x vs ZdfFourPoleMixerModule<2> at 1x", oversampledPath, oversampledFilter);
+    EXPECT_TRUE(std::isfinite(out[0]));
+    EXPECT_TRUE(std::isfinite(data[0]));
+}
+
+// an lfo sweeping the cutoff at audio rate, a setCutoff call per sample (an exp each) against the cutoff buffer
+template <typename Filter>
+void compareSetCutoffPerSampleWithCutoffBuffer(const char* name)
+{
+    constexpr size_t blockSize{128};
+    std::array<float, blockSize> noise{};
+    std::mt19937 generator(9);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::generate(noise.begin(), noise.end(), [&]() { return distribution(generator); });
+    // one lfo cycle of 0.5 seconds, computed upfront so the sine doesn't count
+    std::vector<float> lfo(blockSize * 187);
+    for (size_t i = 0; i < lfo.size(); ++i)
+    {
+        const auto phase = 2.f * static_cast<float>(M_PI) * static_cast<float>(i) / static_cast<float>(lfo.size());
+        lfo[i] = 2600.f + 2400.f * std::sin(phase);
+    }
+    size_t lfoIndex{0};
+    const float* cutoff{nullptr};
+    const auto nextCutoffs = [&]()
+    {
+        cutoff = lfo.data() + lfoIndex;
+        lfoIndex = (lfoIndex + blockSize) % lfo.size();
+    };
+
+    Filter perSample(48000.f);
+    Filter buffered(48000.f);
+    perSample.setResonance(0.5f);
+    buffered.setResonance(0.5f);
+    if constexpr (requires { perSample.setSmoothingSteps(0); })
+    {
+        perSample.setSmoothingSteps(0);
+    }
+    std::array<float, blockSize> out{};
+    compareRunners(
+        name,
+        [&]()
+        {
+            nextCutoffs();
+            for (size_t i = 0; i < blockSize; ++i)
+            {
+                perSample.setCutoff(cutoff[i]);
+                perSample.processBlock(noise.data() + i, out.data() + i, 1);
+            }
+        },
+        [&]()
+        {
+            nextCutoffs();
+            buffered.processBlock(noise.data(), cutoff, out.data(), blockSize);
+        });
+    EXPECT_TRUE(std::isfinite(out[0]));
+}
+
+TEST(FourPoleFilterPerformanceTest, compareSetCutoffPerSampleWithCutoffBuffer)
+{
+    compareSetCutoffPerSampleWithCutoffBuffer<DSP::Lp24Smooth>("Lp24Smooth setCutoff per sample vs cutoff buffer");
+    compareSetCutoffPerSampleWithCutoffBuffer<DSP::ZdfFourPoleMixerModule<2>>(
+        "ZdfFourPoleMixerModule<2> setCutoff per sample vs cutoff buffer");
+}
 }
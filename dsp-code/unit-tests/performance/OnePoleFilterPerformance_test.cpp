@@ -4,7 +4,11 @@
 #include "DspPerformance.h"
 #include "OnePoleFilter.h"
 
+#include <array>
 #include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
 
 namespace DspPerformanceTest
 {
@@ -132,4 +136,107 @@ TEST(OnePoleFilterPerformanceTest, compareOlder)
     std::cout << "Local speed factor: " << sutOptimized.samplesProcessed() / 48000.f / oneBurnInSeconds << std::endl;
 }
 
+TEST(OnePoleFilterPerformanceTest, compareScanWithSerial)
+{
+    constexpr size_t numSamples{1 << 20};
+    for (size_t blockSize = 16; blockSize <= 4096; blockSize *= 2)
+    {
+        DSP::OnePoleFilter serial(48000.f, 1000.f);
+        DSP::OnePoleFilterOptimized scan(48000.f, 1000.f);
+        std::vector<float> source(blockSize, 0.f);
+        for (size_t i = 0; i < blockSize; ++i)
+        {
+            source[i] = (i * 7919 % 1024) / 512.f - 1.f; // noise, an impulse would decay into subnormals
+        }
+        std::vector<float> data(blockSize, 0.f);
+
+        // nanoseconds per sample
+        const auto measure = [&](auto& sut)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < numSamples; done += blockSize)
+            {
+                sut.processBlock(source.data(), data.data(), blockSize);
+            }
+            const auto stop = std::chrono::steady_clock::now();
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()) /
+                   static_cast<double>(numSamples);
+        };
+        const auto serialTime = measure(serial);
+        const auto scanTime = measure(scan);
+        EXPECT_NE(data[0], 0);
+        std::cout << "block " << std::setw(4) << blockSize << ": serial " << std::setw(8) << serialTime
+                  << " ns scan " << std::setw(8) << scanTime
+                  << " ns r: " << static_cast<int>(serialTime * 100 / scanTime) << "%" << std::endl;
+    }
+}
+
+TEST(OnePoleFilterPerformanceTest, compareFiltersWithBank)
+{
+    constexpr size_t NumFollowers{64};
+    constexpr size_t blockSize{128};
+
+    // 64 envelope followers, one object per follower
+    class SUTBase
+    {
+      public:
+        SUTBase()
+        {
+            for (size_t c = 0; c < NumFollowers; ++c)
+            {
+                m_filters.emplace_back(48000.f, 5.f + static_cast<float>(c));
+                m_data[c].fill(0.5f);
+                m_pointers[c] = m_data[c].data();
+            }
+        }
+
+        void process()
+        {
+            for (size_t c = 0; c < NumFollowers; ++c)
+            {
+                m_filters[c].processBlock(m_data[c].data(), blockSize);
+            }
+            EXPECT_NE(m_data[0][0], 0);
+        }
+
+      protected:
+        std::vector<DSP::OnePoleFilter> m_filters;
+        std::array<std::array<float, blockSize>, NumFollowers> m_data{};
+        std::array<float*, NumFollowers> m_pointers{};
+    };
+
+    class SUTOptimized : public SUTBase
+    {
+      public:
+        SUTOptimized()
+        {
+            for (size_t c = 0; c < NumFollowers; ++c)
+            {
+                m_bank.setCutoff(c, 5.f + static_cast<float>(c));
+            }
+        }
+
+        void process()
+        {
+            m_bank.processBlock(m_pointers.data(), m_pointers.data(), blockSize);
+            EXPECT_NE(m_data[0][0], 0);
+        }
+
+      private:
+        DSP::OnePoleBank<NumFollowers> m_bank{48000.f};
+    };
+
+    const auto seconds = .5f;
+    SUTBase sutBase;
+    SUTOptimized sutOptimized;
+    const auto baseRunner = [&sutBase]() { sutBase.process(); };
+    const auto optimizedRunner = [&sutOptimized]() { sutOptimized.process(); };
+
+    TestCompare testCompare;
+    const auto iterationsForOneRound = testCompare.getIterationsForACertainPeriod(baseRunner, seconds);
+
+    testCompare.runSingleTest(baseRunner, optimizedRunner, iterationsForOneRound);
+    testCompare.printResult(blockSize * iterationsForOneRound, seconds, 48000.f);
+}
+
 }
@@ -7,7 +7,9 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
+#include <iostream>
 #include <numbers>
 
 namespace DspPerformanceTest
@@ -77,7 +79,7 @@ TEST(TwoLatticeAllPassPerformanceTest, compareOlder)
         }
 
       private:
-        DSP::TwoLatticeAllPass<1000> sut{sampleRate};
+        DSP::TwoLatticeAllPassPerSample<1000> sut{sampleRate};
         std::array<float, 1024> m_data{};
         size_t m_samplesProcessed{0};
     };
@@ -137,4 +139,41 @@ TEST(TwoLatticeAllPassPerformanceTest, compareOlder)
     }
     std::cout << "Local speed factor: " << sutOptimized.samplesProcessed() / 48000.f / oneBurnInSeconds << std::endl;
 }
+
+// per sample against segments, with the sizes of the diffusor of KindOfADelay and a short one
+TEST(TwoLatticeAllPassPerformanceTest, compareSegments)
+{
+#if !NDEBUG
+    std::cerr << __FILE_NAME__ << ": Warning! Debug version should not be compared!" << std::endl;
+#endif
+    constexpr float sampleRate{48000.f};
+    constexpr size_t blockSize{128};
+    constexpr size_t numBlocks{static_cast<size_t>(sampleRate) * 60 / blockSize};
+    const auto render = [&](auto& allPass, const size_t size)
+    {
+        allPass.setSize(size);
+        allPass.setFeedback(0.6f);
+        allPass.setLowpassCutoff(8000.f);
+        std::array<float, blockSize> data{};
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t block = 0; block < numBlocks; ++block)
+        {
+            data[0] = 1.f;
+            allPass.processBlockInplace(data.data(), blockSize);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        EXPECT_NE(data[0], 20.f);
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()) /
+               1000.0;
+    };
+    for (const size_t size : {51, 229, 611})
+    {
+        DSP::TwoLatticeAllPassPerSample<1000> perSample{sampleRate};
+        DSP::TwoLatticeAllPass<1000> segments{sampleRate};
+        const auto base = render(perSample, size);
+        const auto optimized = render(segments, size);
+        std::cout << "60 seconds with a size of " << size << ", per sample: " << base << " ms, segments: " << optimized
+                  << " ms r: " << static_cast<int>(base * 100 / optimized) << "%" << std::endl;
+    }
+}
 }